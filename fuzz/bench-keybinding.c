@@ -0,0 +1,124 @@
+// Copyright 2020 - 2025, project-repo and the NEDM contributors
+// SPDX-License-Identifier: MIT
+
+#define _POSIX_C_SOURCE 200812L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <xkbcommon/xkbcommon.h>
+
+#include "../keybinding.h"
+
+#define BENCH_MODES 3
+#define BENCH_LOOKUPS 2000000
+
+/* Lookup as done before keybindings were indexed, kept as the baseline */
+static struct keybinding **
+find_keybinding_linear(const struct keybinding_list *list,
+                       const struct keybinding *keybinding) {
+	struct keybinding **it = list->keybindings;
+	for(size_t i = 0; i < list->length; ++i, ++it) {
+		if(!(keybinding->modifiers ^ (*it)->modifiers) &&
+		   keybinding->mode == (*it)->mode && keybinding->key == (*it)->key) {
+			return it;
+		}
+	}
+	return NULL;
+}
+
+static double
+elapsed_ns(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) * 1e9 +
+	       (end->tv_nsec - start->tv_nsec);
+}
+
+/* Every other lookup misses, like key presses which are passed on to the
+ * client */
+static void
+fill_queries(struct keybinding *queries, uint32_t nbindings) {
+	for(uint32_t i = 0; i < BENCH_LOOKUPS; ++i) {
+		uint32_t n = (i * 7919u) % (2 * nbindings);
+		queries[i] = (struct keybinding){
+		    .mode = n % BENCH_MODES,
+		    .modifiers = (n / BENCH_MODES) % 4,
+		    .key = XKB_KEY_a + n,
+		};
+	}
+}
+
+static double
+bench(const struct keybinding_list *list, const struct keybinding *queries,
+      struct keybinding **(*find)(const struct keybinding_list *,
+                                  const struct keybinding *),
+      uint32_t *hits) {
+	struct timespec start, end;
+	*hits = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(uint32_t i = 0; i < BENCH_LOOKUPS; ++i) {
+		if(find(list, &queries[i]) != NULL) {
+			++*hits;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return elapsed_ns(&start, &end) / BENCH_LOOKUPS;
+}
+
+static int
+bench_bindings(uint32_t nbindings, struct keybinding *queries) {
+	struct keybinding_list *list = keybinding_list_init();
+	if(list == NULL) {
+		return -1;
+	}
+	for(uint32_t n = 0; n < nbindings; ++n) {
+		struct keybinding *keybinding = calloc(1, sizeof(*keybinding));
+		if(keybinding == NULL) {
+			keybinding_list_free(list);
+			return -1;
+		}
+		keybinding->mode = n % BENCH_MODES;
+		keybinding->modifiers = (n / BENCH_MODES) % 4;
+		keybinding->key = XKB_KEY_a + n;
+		keybinding->action = KEYBINDING_NOOP;
+		if(keybinding_list_push(list, keybinding) != 0) {
+			free(keybinding);
+			keybinding_list_free(list);
+			return -1;
+		}
+	}
+
+	fill_queries(queries, nbindings);
+	uint32_t linear_hits, index_hits;
+	double linear = bench(list, queries, find_keybinding_linear, &linear_hits);
+	double index = bench(list, queries, find_keybinding, &index_hits);
+	keybinding_list_free(list);
+
+	printf("%6u bindings: linear %8.1f ns, index %6.1f ns per lookup\n",
+	       nbindings, linear, index);
+	if(linear_hits != index_hits) {
+		fprintf(stderr, "Lookups disagree: %u hits linear, %u indexed\n",
+		        linear_hits, index_hits);
+		return -1;
+	}
+	return 0;
+}
+
+int
+main(void) {
+	static const uint32_t sizes[] = {16, 64, 256, 1024};
+	struct keybinding *queries = calloc(BENCH_LOOKUPS, sizeof(*queries));
+	if(queries == NULL) {
+		return 1;
+	}
+	int ret = 0;
+	for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+		if(bench_bindings(sizes[i], queries) != 0) {
+			ret = 1;
+			break;
+		}
+	}
+	free(queries);
+	return ret;
+}
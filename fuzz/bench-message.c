@@ -0,0 +1,66 @@
+// Copyright 2020 - 2025, project-repo and the NEDM contributors
+// SPDX-License-Identifier: MIT
+
+#define _POSIX_C_SOURCE 200812L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <wayland-server-core.h>
+
+#include "../message.h"
+#include "../output.h"
+#include "../server.h"
+
+#include "fuzz-lib.h"
+
+#define BENCH_MESSAGES 20000
+
+static double
+elapsed_us(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) * 1e6 +
+	       (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+/* Show and clear messages like the workspace indicator. With distinct set,
+ * every message has a new text, so it misses the message cache and has to be
+ * rendered. */
+static double
+bench(struct nedm_output *output, bool distinct) {
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(uint32_t i = 0; i < BENCH_MESSAGES; ++i) {
+		if(distinct) {
+			message_printf(output, "Message %u", i);
+		} else {
+			message_printf(output, "Workspace %u", i % 4 + 1);
+		}
+		message_clear(output);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return elapsed_us(&start, &end) / BENCH_MESSAGES;
+}
+
+int
+main(int argc, char **argv) {
+	if(LLVMFuzzerInitialize(&argc, &argv) != 0 ||
+	   wl_list_empty(&server.outputs)) {
+		fprintf(stderr, "Failed to set up the headless backend\n");
+		return 1;
+	}
+	server.message_config.enabled = 1;
+	server.message_config.anchor = NEDM_MESSAGE_TOP_RIGHT;
+	struct nedm_output *output =
+	    wl_container_of(server.outputs.next, output, link);
+
+	double repeated = bench(output, false);
+	double distinct = bench(output, true);
+	printf("message_printf + message_clear: repeated %.1f us, distinct %.1f "
+	       "us per message\n",
+	       repeated, distinct);
+	printf("message cache: %lu hits, %lu misses\n",
+	       (unsigned long)server.message_cache.hits,
+	       (unsigned long)server.message_cache.misses);
+	return 0;
+}
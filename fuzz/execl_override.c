@@ -27,3 +27,9 @@ cairo_surface_t *
 cairo_image_surface_create(cairo_format_t fmt, int width, int height) {
 	return NULL;
 }
+
+cairo_surface_t *
+cairo_image_surface_create_for_data(unsigned char *data, cairo_format_t fmt,
+                                    int width, int height, int stride) {
+	return NULL;
+}
@@ -52,6 +52,7 @@
 #include "../parse.h"
 #include "../seat.h"
 #include "../server.h"
+#include "../wallpaper.h"
 #include "../xdg_shell.h"
 #if NEDM_HAS_XWAYLAND
 #include "../xwayland.h"
@@ -133,6 +134,8 @@ LLVMFuzzerInitialize(int *argc, char ***argv) {
 	wl_list_init(&server.output_priorities);
 	wl_list_init(&server.outputs);
 	wl_list_init(&server.disabled_outputs);
+	message_cache_init(&server);
+	nedm_wallpaper_init(&server);
 
 	int ret = 0;
 
@@ -34,7 +34,7 @@ set_configuration(struct nedm_server *server, char *content) {
 		if(*line != '\0' && *line != '#') {
 			char *errstr = NULL;
 			server->running = true;
-			if(parse_rc_line(server, line, &errstr) != 0) {
+			if(parse_rc_line(server, line, &errstr, NULL) != 0) {
 				if(errstr != NULL) {
 					free(errstr);
 				}
@@ -0,0 +1,172 @@
+// Copyright 2020 - 2025, project-repo and the NEDM contributors
+// SPDX-License-Identifier: MIT
+
+#define _POSIX_C_SOURCE 200812L
+
+#include <cairo.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <wayland-server-core.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/types/wlr_scene.h>
+#include <wlr/util/log.h>
+
+#include "../output.h"
+#include "../server.h"
+#include "../wallpaper.h"
+
+#include "fuzz-lib.h"
+
+#define TEST_IMAGE_WIDTH 64
+#define TEST_IMAGE_HEIGHT 32
+
+static char test_dir[] = "/tmp/nedm-test-XXXXXX";
+static char image_path[sizeof(test_dir) + sizeof("/wallpaper.png")];
+
+static bool
+write_test_image(void) {
+	if(mkdtemp(test_dir) == NULL) {
+		perror("mkdtemp");
+		return false;
+	}
+	snprintf(image_path, sizeof(image_path), "%s/wallpaper.png", test_dir);
+	cairo_surface_t *surface = cairo_image_surface_create(
+	    CAIRO_FORMAT_RGB24, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT);
+	cairo_t *cairo = cairo_create(surface);
+	cairo_set_source_rgb(cairo, 0.2, 0.4, 0.6);
+	cairo_paint(cairo);
+	cairo_destroy(cairo);
+	cairo_status_t status = cairo_surface_write_to_png(surface, image_path);
+	cairo_surface_destroy(surface);
+	if(status != CAIRO_STATUS_SUCCESS) {
+		fprintf(stderr, "Failed to write %s: %s\n", image_path,
+		        cairo_status_to_string(status));
+		return false;
+	}
+	return true;
+}
+
+/* Check that the wallpaper covers the output at its current geometry, both
+ * in layout coordinates and in pixels of the rasterized buffer */
+static bool
+check_wallpaper(struct nedm_output *output, const char *step, int width,
+                int height, float scale) {
+	struct nedm_wallpaper *wallpaper = output->wallpaper;
+	bool ok = true;
+	if(wallpaper->output_width != (uint32_t)width ||
+	   wallpaper->output_height != (uint32_t)height ||
+	   wallpaper->output_scale != scale) {
+		fprintf(stderr, "%s: wallpaper geometry is %ux%u@%.2f, expected "
+		                "%dx%d@%.2f\n",
+		        step, wallpaper->output_width, wallpaper->output_height,
+		        wallpaper->output_scale, width, height, scale);
+		ok = false;
+	}
+	if(wallpaper->background->width != width ||
+	   wallpaper->background->height != height) {
+		fprintf(stderr, "%s: background is %dx%d, expected %dx%d\n", step,
+		        wallpaper->background->width, wallpaper->background->height,
+		        width, height);
+		ok = false;
+	}
+	struct wlr_scene_buffer *scene_buffer = wallpaper->scene_buffer;
+	if(!scene_buffer->node.enabled || scene_buffer->buffer == NULL) {
+		fprintf(stderr, "%s: wallpaper image is not shown\n", step);
+		return false;
+	}
+	if(scene_buffer->dst_width != width || scene_buffer->dst_height != height) {
+		fprintf(stderr, "%s: wallpaper is shown at %dx%d, expected %dx%d\n",
+		        step, scene_buffer->dst_width, scene_buffer->dst_height, width,
+		        height);
+		ok = false;
+	}
+	if(wallpaper->cpu_render) {
+		struct wlr_buffer *buffer = scene_buffer->buffer;
+		int buffer_width = ceil(width * scale);
+		int buffer_height = ceil(height * scale);
+		if(wallpaper->render == NULL ||
+		   wallpaper->render->buffer != buffer ||
+		   buffer->width != buffer_width || buffer->height != buffer_height) {
+			fprintf(stderr,
+			        "%s: wallpaper was rendered at %dx%d, expected %dx%d\n",
+			        step, buffer->width, buffer->height, buffer_width,
+			        buffer_height);
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+static bool
+commit_output(struct nedm_output *output, struct wlr_output_state *state,
+              const char *step) {
+	bool committed = wlr_output_commit_state(output->wlr_output, state);
+	wlr_output_state_finish(state);
+	if(!committed) {
+		fprintf(stderr, "%s: commit failed\n", step);
+	}
+	return committed;
+}
+
+int
+main(int argc, char **argv) {
+	if(!write_test_image()) {
+		return 1;
+	}
+	if(getenv("XDG_RUNTIME_DIR") == NULL) {
+		setenv("XDG_RUNTIME_DIR", test_dir, true);
+	}
+	server.wallpaper_config.image_path = image_path;
+	server.wallpaper_config.mode = NEDM_WALLPAPER_FILL;
+	server.wallpaper_config.bg_color[3] = 1.0;
+
+	int ret = 1;
+	if(LLVMFuzzerInitialize(&argc, &argv) != 0 ||
+	   wl_list_empty(&server.outputs)) {
+		fprintf(stderr, "Failed to set up the headless backend\n");
+		goto end;
+	}
+	struct nedm_output *output =
+	    wl_container_of(server.outputs.next, output, link);
+	if(output->wallpaper == NULL) {
+		fprintf(stderr, "No wallpaper was created for the output\n");
+		goto end;
+	}
+	/* Size of the headless output created by LLVMFuzzerInitialize */
+	if(!check_wallpaper(output, "initial", 600, 300, 1)) {
+		goto end;
+	}
+
+	struct wlr_output_state state;
+	wlr_output_state_init(&state);
+	wlr_output_state_set_custom_mode(&state, 800, 600, 0);
+	if(!commit_output(output, &state, "mode") ||
+	   !check_wallpaper(output, "mode", 800, 600, 1)) {
+		goto end;
+	}
+
+	wlr_output_state_init(&state);
+	wlr_output_state_set_scale(&state, 2);
+	if(!commit_output(output, &state, "scale") ||
+	   !check_wallpaper(output, "scale", 400, 300, 2)) {
+		goto end;
+	}
+
+	wlr_output_state_init(&state);
+	wlr_output_state_set_transform(&state, WL_OUTPUT_TRANSFORM_90);
+	if(!commit_output(output, &state, "transform") ||
+	   !check_wallpaper(output, "transform", 300, 400, 2)) {
+		goto end;
+	}
+	ret = 0;
+
+end:
+	server.wallpaper_config.image_path = NULL;
+	unlink(image_path);
+	rmdir(test_dir);
+	return ret;
+}
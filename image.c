@@ -0,0 +1,345 @@
+// Copyright 2020 - 2025, project-repo and the NEDM contributors
+// SPDX-License-Identifier: MIT
+
+#include <cairo.h>
+#include <math.h>
+#include <png.h>
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wlr/util/log.h>
+/* jpeglib.h does not include its dependencies */
+#include <jpeglib.h>
+
+#include "image.h"
+
+/* Box filter which downsamples the rows of an image as they are decoded */
+struct image_scaler {
+	cairo_surface_t *surface;
+	uint32_t src_width;
+	uint32_t src_height;
+	uint32_t dst_width;
+	uint32_t dst_height;
+	uint32_t src_y;     // Next source row
+	uint32_t nrows;     // Source rows summed up in sums
+	uint32_t *columns;  // Destination column of each source column
+	uint32_t *ncolumns; // Number of source columns of each destination column
+	uint64_t *sums;     // Premultiplied ARGB sums of the current row
+};
+
+static void
+image_target_size(uint32_t src_width, uint32_t src_height, uint32_t width,
+                  uint32_t height, enum nedm_image_fit fit,
+                  uint32_t *dst_width, uint32_t *dst_height) {
+	*dst_width = src_width;
+	*dst_height = src_height;
+	if(fit == NEDM_IMAGE_FIT_NONE || width == 0 || height == 0) {
+		return;
+	}
+	double scale_x = (double)width / src_width;
+	double scale_y = (double)height / src_height;
+	double scale = fit == NEDM_IMAGE_FIT_COVER ? fmax(scale_x, scale_y)
+	                                           : fmin(scale_x, scale_y);
+	if(scale >= 1) {
+		return;
+	}
+	*dst_width = fmax(ceil(src_width * scale), 1);
+	*dst_height = fmax(ceil(src_height * scale), 1);
+}
+
+static void
+image_scaler_destroy(struct image_scaler *scaler) {
+	if(scaler == NULL) {
+		return;
+	}
+	if(scaler->surface != NULL) {
+		cairo_surface_destroy(scaler->surface);
+	}
+	free(scaler->columns);
+	free(scaler->ncolumns);
+	free(scaler->sums);
+	free(scaler);
+}
+
+static struct image_scaler *
+image_scaler_create(uint32_t src_width, uint32_t src_height,
+                    uint32_t dst_width, uint32_t dst_height, bool alpha) {
+	struct image_scaler *scaler = calloc(1, sizeof(struct image_scaler));
+	if(scaler == NULL) {
+		return NULL;
+	}
+	scaler->src_width = src_width;
+	scaler->src_height = src_height;
+	scaler->dst_width = dst_width;
+	scaler->dst_height = dst_height;
+	scaler->surface = cairo_image_surface_create(
+	    alpha ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24, dst_width,
+	    dst_height);
+	scaler->columns = calloc(src_width, sizeof(uint32_t));
+	scaler->ncolumns = calloc(dst_width, sizeof(uint32_t));
+	scaler->sums = calloc(4 * (size_t)dst_width, sizeof(uint64_t));
+	if(cairo_surface_status(scaler->surface) != CAIRO_STATUS_SUCCESS ||
+	   scaler->columns == NULL || scaler->ncolumns == NULL ||
+	   scaler->sums == NULL) {
+		image_scaler_destroy(scaler);
+		return NULL;
+	}
+	for(uint32_t x = 0; x < src_width; ++x) {
+		scaler->columns[x] = (uint64_t)x * dst_width / src_width;
+		++scaler->ncolumns[scaler->columns[x]];
+	}
+	return scaler;
+}
+
+static void
+image_scaler_flush(struct image_scaler *scaler, uint32_t y) {
+	unsigned char *data = cairo_image_surface_get_data(scaler->surface);
+	int stride = cairo_image_surface_get_stride(scaler->surface);
+	uint32_t *row = (uint32_t *)(data + (size_t)y * stride);
+	for(uint32_t x = 0; x < scaler->dst_width; ++x) {
+		uint64_t n = (uint64_t)scaler->ncolumns[x] * scaler->nrows;
+		uint64_t *sum = &scaler->sums[4 * x];
+		row[x] = (uint32_t)((sum[0] + n / 2) / n) << 24 |
+		         (uint32_t)((sum[1] + n / 2) / n) << 16 |
+		         (uint32_t)((sum[2] + n / 2) / n) << 8 |
+		         (uint32_t)((sum[3] + n / 2) / n);
+	}
+	memset(scaler->sums, 0, 4 * scaler->dst_width * sizeof(uint64_t));
+	scaler->nrows = 0;
+}
+
+/* Adds a row of 8 bit RGB or RGBA pixels (not premultiplied) */
+static void
+image_scaler_add_row(struct image_scaler *scaler, const uint8_t *pixels,
+                     int channels) {
+	if(scaler->src_y >= scaler->src_height) {
+		return;
+	}
+	for(uint32_t x = 0; x < scaler->src_width; ++x) {
+		const uint8_t *p = &pixels[x * channels];
+		uint32_t a = channels == 4 ? p[3] : 0xff;
+		uint64_t *sum = &scaler->sums[4 * scaler->columns[x]];
+		sum[0] += a;
+		sum[1] += (p[0] * a + 127) / 255;
+		sum[2] += (p[1] * a + 127) / 255;
+		sum[3] += (p[2] * a + 127) / 255;
+	}
+	++scaler->nrows;
+
+	uint32_t y =
+	    (uint64_t)scaler->src_y * scaler->dst_height / scaler->src_height;
+	++scaler->src_y;
+	if(scaler->src_y == scaler->src_height ||
+	   (uint64_t)scaler->src_y * scaler->dst_height / scaler->src_height !=
+	       y) {
+		image_scaler_flush(scaler, y);
+	}
+}
+
+/* Returns the downsampled image and destroys the scaler */
+static cairo_surface_t *
+image_scaler_finish(struct image_scaler *scaler) {
+	cairo_surface_t *surface = NULL;
+	if(scaler->src_y == scaler->src_height) {
+		surface = scaler->surface;
+		scaler->surface = NULL;
+		cairo_surface_mark_dirty(surface);
+	}
+	image_scaler_destroy(scaler);
+	return surface;
+}
+
+static cairo_surface_t *
+image_load_png(FILE *file, uint32_t width, uint32_t height,
+               enum nedm_image_fit fit) {
+	png_structp png =
+	    png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	png_infop info = png != NULL ? png_create_info_struct(png) : NULL;
+	if(info == NULL) {
+		png_destroy_read_struct(&png, NULL, NULL);
+		return NULL;
+	}
+
+	/* Modified after setjmp, so they have to be volatile */
+	struct image_scaler *volatile scaler = NULL;
+	uint8_t *volatile pixels = NULL;
+	png_bytep *volatile rows = NULL;
+	cairo_surface_t *surface = NULL;
+	if(setjmp(png_jmpbuf(png))) {
+		wlr_log(WLR_ERROR, "Failed to decode PNG image");
+		goto end;
+	}
+
+	png_init_io(png, file);
+	png_read_info(png, info);
+	uint32_t src_width = png_get_image_width(png, info);
+	uint32_t src_height = png_get_image_height(png, info);
+	bool alpha = (png_get_color_type(png, info) & PNG_COLOR_MASK_ALPHA) ||
+	             png_get_valid(png, info, PNG_INFO_tRNS);
+
+	/* Convert every format to 8 bit RGBA */
+	png_set_expand(png);
+	png_set_strip_16(png);
+	png_set_gray_to_rgb(png);
+	png_set_add_alpha(png, 0xff, PNG_FILLER_AFTER);
+	int passes = png_set_interlace_handling(png);
+	png_read_update_info(png, info);
+
+	uint32_t dst_width, dst_height;
+	image_target_size(src_width, src_height, width, height, fit, &dst_width,
+	                  &dst_height);
+	scaler = image_scaler_create(src_width, src_height, dst_width,
+	                             dst_height, alpha);
+	size_t stride = (size_t)src_width * 4;
+	if(scaler == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate image of size %ux%u",
+		        dst_width, dst_height);
+		goto end;
+	}
+
+	if(passes > 1) {
+		/* Interlaced images can only be scaled once all passes are read */
+		pixels = malloc(stride * src_height);
+		rows = malloc(src_height * sizeof(png_bytep));
+		if(pixels == NULL || rows == NULL) {
+			wlr_log(WLR_ERROR, "Failed to allocate interlaced PNG image");
+			goto end;
+		}
+		for(uint32_t y = 0; y < src_height; ++y) {
+			rows[y] = pixels + y * stride;
+		}
+		png_read_image(png, rows);
+		for(uint32_t y = 0; y < src_height; ++y) {
+			image_scaler_add_row(scaler, rows[y], 4);
+		}
+	} else {
+		pixels = malloc(stride);
+		if(pixels == NULL) {
+			goto end;
+		}
+		for(uint32_t y = 0; y < src_height; ++y) {
+			png_read_row(png, pixels, NULL);
+			image_scaler_add_row(scaler, pixels, 4);
+		}
+	}
+	surface = image_scaler_finish(scaler);
+	scaler = NULL;
+
+end:
+	image_scaler_destroy(scaler);
+	free(rows);
+	free(pixels);
+	png_destroy_read_struct(&png, &info, NULL);
+	return surface;
+}
+
+struct image_jpeg_error {
+	struct jpeg_error_mgr base;
+	jmp_buf jmp;
+};
+
+static void
+image_jpeg_error_exit(j_common_ptr cinfo) {
+	struct image_jpeg_error *error = (struct image_jpeg_error *)cinfo->err;
+	char message[JMSG_LENGTH_MAX];
+	cinfo->err->format_message(cinfo, message);
+	wlr_log(WLR_ERROR, "Failed to decode JPEG image: %s", message);
+	longjmp(error->jmp, 1);
+}
+
+static void
+image_jpeg_output_message(__attribute__((unused)) j_common_ptr cinfo) {
+	// Warnings about corrupt data are not worth logging
+}
+
+static cairo_surface_t *
+image_load_jpeg(FILE *file, uint32_t width, uint32_t height,
+                enum nedm_image_fit fit) {
+	struct jpeg_decompress_struct cinfo;
+	struct image_jpeg_error error;
+	cinfo.err = jpeg_std_error(&error.base);
+	error.base.error_exit = image_jpeg_error_exit;
+	error.base.output_message = image_jpeg_output_message;
+
+	/* Modified after setjmp, so they have to be volatile */
+	struct image_scaler *volatile scaler = NULL;
+	uint8_t *volatile pixels = NULL;
+	cairo_surface_t *surface = NULL;
+	if(setjmp(error.jmp)) {
+		goto end;
+	}
+
+	jpeg_create_decompress(&cinfo);
+	jpeg_stdio_src(&cinfo, file);
+	jpeg_read_header(&cinfo, TRUE);
+	cinfo.out_color_space = JCS_RGB;
+
+	uint32_t dst_width, dst_height;
+	image_target_size(cinfo.image_width, cinfo.image_height, width, height,
+	                  fit, &dst_width, &dst_height);
+	/* Let the IDCT do as much of the downsampling as possible, which is
+	 * much cheaper than decoding at full resolution */
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = 1;
+	while(cinfo.scale_denom < 8 &&
+	      cinfo.image_width / (cinfo.scale_denom * 2) >= dst_width &&
+	      cinfo.image_height / (cinfo.scale_denom * 2) >= dst_height) {
+		cinfo.scale_denom *= 2;
+	}
+	jpeg_start_decompress(&cinfo);
+	if(dst_width > cinfo.output_width || dst_height > cinfo.output_height) {
+		dst_width = cinfo.output_width;
+		dst_height = cinfo.output_height;
+	}
+
+	scaler = image_scaler_create(cinfo.output_width, cinfo.output_height,
+	                             dst_width, dst_height, false);
+	pixels = malloc((size_t)cinfo.output_width * cinfo.output_components);
+	if(scaler == NULL || pixels == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate image of size %ux%u",
+		        dst_width, dst_height);
+		goto end;
+	}
+	while(cinfo.output_scanline < cinfo.output_height) {
+		JSAMPROW row = pixels;
+		jpeg_read_scanlines(&cinfo, &row, 1);
+		image_scaler_add_row(scaler, pixels, cinfo.output_components);
+	}
+	jpeg_finish_decompress(&cinfo);
+	surface = image_scaler_finish(scaler);
+	scaler = NULL;
+
+end:
+	image_scaler_destroy(scaler);
+	free(pixels);
+	jpeg_destroy_decompress(&cinfo);
+	return surface;
+}
+
+cairo_surface_t *
+image_load(const char *path, uint32_t width, uint32_t height,
+           enum nedm_image_fit fit) {
+	FILE *file = fopen(path, "rb");
+	if(file == NULL) {
+		wlr_log_errno(WLR_ERROR, "Failed to open image %s", path);
+		return NULL;
+	}
+
+	uint8_t magic[8];
+	cairo_surface_t *surface = NULL;
+	size_t len = fread(magic, 1, sizeof(magic), file);
+	rewind(file);
+	if(len == sizeof(magic) && png_sig_cmp(magic, 0, sizeof(magic)) == 0) {
+		surface = image_load_png(file, width, height, fit);
+	} else if(len >= 3 && magic[0] == 0xff && magic[1] == 0xd8 &&
+	          magic[2] == 0xff) {
+		surface = image_load_jpeg(file, width, height, fit);
+	} else {
+		wlr_log(WLR_ERROR, "Unsupported image format of %s", path);
+	}
+	fclose(file);
+	return surface;
+}
@@ -0,0 +1,26 @@
+// Copyright 2020 - 2025, project-repo and the NEDM contributors
+// SPDX-License-Identifier: MIT
+
+#ifndef NEDM_IMAGE_H
+#define NEDM_IMAGE_H
+
+#include <cairo.h>
+#include <stdint.h>
+
+/* How an image is downsampled to the target size while it is decoded. The
+ * aspect ratio is always kept and images are never upsampled. */
+enum nedm_image_fit {
+	NEDM_IMAGE_FIT_NONE,    // Decode at full resolution
+	NEDM_IMAGE_FIT_COVER,   // Cover the target in both dimensions
+	NEDM_IMAGE_FIT_CONTAIN, // Fit within the target
+};
+
+/* Decodes the PNG or JPEG image at path row by row, downsampling it to width
+ * x height on the way. Peak memory is bounded by the target size rather than
+ * the size of the image (except for interlaced PNGs). Returns NULL on
+ * failure. May be called from any thread. */
+cairo_surface_t *
+image_load(const char *path, uint32_t width, uint32_t height,
+           enum nedm_image_fit fit);
+
+#endif
@@ -9,18 +9,82 @@
 #include "server.h"
 #include "util.h"
 
+#include <ctype.h>
 #include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 #include <wlr/util/log.h>
 
 static const char ipc_magic[] = {'c', 'g', '-', 'i', 'p', 'c'};
 
+const char *ipc_event_string[] = {FOREACH_IPC_EVENT(GENERATE_IPC_EVENT_STRING)};
+
 #define IPC_HEADER_SIZE sizeof(ipc_magic)
+/* Maximum number of events written to a client at once */
+#define IPC_IOV_MAX 64
+/* Maximum length of the id of a request */
+#define IPC_REQUEST_ID_MAX 64
+
+static const char *
+ipc_policy_to_str(enum nedm_ipc_policy policy) {
+	switch(policy) {
+	case NEDM_IPC_POLICY_DISCONNECT:
+		return "disconnect";
+	case NEDM_IPC_POLICY_DROP_OLDEST:
+		return "drop_oldest";
+	case NEDM_IPC_POLICY_COALESCE:
+		return "coalesce";
+	default:
+		return "unknown";
+	}
+}
+
+/* Reports to each client how many events it lost since the last report */
+static int
+handle_ipc_stats_timer(void *data) {
+	struct nedm_server *server = data;
+	struct nedm_ipc_handle *ipc = &server->ipc;
+	struct nedm_ipc_client *it;
+	wl_list_for_each(it, &ipc->client_list, link) {
+		it->stats_pending = it->dropped != it->reported_dropped ||
+		                    it->coalesced != it->reported_coalesced;
+	}
+	/* Sending an event may disconnect slow clients, so start over after
+	 * each report */
+	bool sent;
+	do {
+		sent = false;
+		wl_list_for_each(it, &ipc->client_list, link) {
+			if(!it->stats_pending) {
+				continue;
+			}
+			it->stats_pending = false;
+			it->reported_dropped = it->dropped;
+			it->reported_coalesced = it->coalesced;
+			ipc_send_client_event(
+			    it, NEDM_IPC_EVENT_IPC_STATS,
+			    "{\"event_name\":\"ipc_stats\",\"policy\":\"%s\","
+			    "\"dropped\":%" PRIu64 ",\"coalesced\":%" PRIu64
+			    ",\"lag\":%" PRIu64 "}",
+			    ipc_policy_to_str(it->policy), it->dropped, it->coalesced,
+			    ipc->ring_head - it->cursor);
+			sent = true;
+			break;
+		}
+	} while(sent);
+	if(!wl_list_empty(&ipc->client_list)) {
+		wl_event_source_timer_update(ipc->stats_timer,
+		                             NEDM_IPC_STATS_INTERVAL);
+	}
+	return 0;
+}
 
 static void
 handle_display_destroy(struct wl_listener *listener,
@@ -37,7 +101,11 @@ handle_display_destroy(struct wl_listener *listener,
 		ipc_client_disconnect(client);
 	}
 
+	if(ipc->stats_timer != NULL) {
+		wl_event_source_remove(ipc->stats_timer);
+	}
 	free(ipc->sockaddr);
+	free(ipc->ring);
 
 	wl_list_remove(&ipc->display_destroy.link);
 }
@@ -100,6 +168,24 @@ ipc_init(struct nedm_server *server) {
 		return -1;
 	}
 
+	ipc->ring = calloc(NEDM_IPC_RING_SIZE, sizeof(struct nedm_ipc_slot));
+	if(ipc->ring == NULL) {
+		wlr_log(WLR_ERROR, "Unable to allocate IPC event ring");
+		free(ipc->sockaddr);
+		return -1;
+	}
+	ipc->ring_head = 0;
+	ipc->ring_tail = 0;
+
+	ipc->stats_timer = wl_event_loop_add_timer(
+	    server->event_loop, handle_ipc_stats_timer, server);
+	if(ipc->stats_timer == NULL) {
+		wlr_log(WLR_ERROR, "Unable to create IPC statistics timer");
+		free(ipc->ring);
+		free(ipc->sockaddr);
+		return -1;
+	}
+
 	chmod(ipc->sockaddr->sun_path, 0700);
 	setenv("CAGEBREAK_SOCKET", ipc->sockaddr->sun_path, 1);
 
@@ -114,6 +200,86 @@ ipc_init(struct nedm_server *server) {
 	return 0;
 }
 
+static void
+ipc_slot_unref(struct nedm_ipc_handle *ipc, uint64_t seq) {
+	struct nedm_ipc_slot *slot = &ipc->ring[seq % NEDM_IPC_RING_SIZE];
+	if(--slot->refcount > 0) {
+		return;
+	}
+	free(slot->data);
+	slot->data = NULL;
+	free(slot->output);
+	slot->output = NULL;
+	while(ipc->ring_tail < ipc->ring_head &&
+	      ipc->ring[ipc->ring_tail % NEDM_IPC_RING_SIZE].data == NULL) {
+		++ipc->ring_tail;
+	}
+}
+
+/* Moves the cursor of the client to the next event */
+static void
+ipc_client_advance(struct nedm_ipc_client *client) {
+	ipc_slot_unref(&client->server->ipc, client->cursor);
+	++client->cursor;
+	if(client->partial == NULL) {
+		client->offset = 0;
+	}
+}
+
+enum ipc_delivery {
+	IPC_DELIVER,
+	IPC_SKIP,     // The event is not meant for the client
+	IPC_COALESCE, // A newer state event replaces the event
+};
+
+static enum ipc_delivery
+ipc_client_delivery(struct nedm_ipc_client *client, uint64_t seq) {
+	struct nedm_ipc_slot *slot =
+	    &client->server->ipc.ring[seq % NEDM_IPC_RING_SIZE];
+	/* An event which was partially sent has to be completed */
+	if(seq == client->cursor && client->partial == NULL &&
+	   client->offset > 0) {
+		return IPC_DELIVER;
+	}
+	/* Subscriptions are checked when events for a single client are sent */
+	if(slot->recipient != NULL ? slot->recipient != client
+	                           : !(client->subscriptions &
+	                               NEDM_IPC_EVENT_MASK(slot->event))) {
+		return IPC_SKIP;
+	}
+	if(client->policy == NEDM_IPC_POLICY_COALESCE && slot->superseded) {
+		return IPC_COALESCE;
+	}
+	return IPC_DELIVER;
+}
+
+/* Moves a client lagging behind in a full ring past the oldest event */
+static int
+ipc_client_drop_oldest(struct nedm_ipc_client *client) {
+	struct nedm_ipc_slot *slot =
+	    &client->server->ipc.ring[client->cursor % NEDM_IPC_RING_SIZE];
+	enum ipc_delivery delivery = ipc_client_delivery(client, client->cursor);
+	if(client->partial == NULL && client->offset > 0) {
+		/* Keep the rest of the event being sent, so that the client does
+		 * not receive a truncated event */
+		client->partial_len = slot->len - client->offset;
+		client->partial = malloc(client->partial_len);
+		if(client->partial == NULL) {
+			wlr_log(WLR_ERROR, "Unable to allocate partial IPC event");
+			return -1;
+		}
+		memcpy(client->partial, slot->data + client->offset,
+		       client->partial_len);
+		client->offset = 0;
+	} else if(delivery == IPC_DELIVER) {
+		++client->dropped;
+	} else if(delivery == IPC_COALESCE) {
+		++client->coalesced;
+	}
+	ipc_client_advance(client);
+	return 0;
+}
+
 int
 ipc_client_handle_writable(__attribute__((unused)) int client_fd, uint32_t mask,
                            void *data) {
@@ -132,22 +298,73 @@ ipc_client_handle_writable(__attribute__((unused)) int client_fd, uint32_t mask,
 	if(fcntl(client->fd, F_GETFD) == -1) {
 		return 0;
 	}
-	ssize_t written =
-	    write(client->fd, client->write_buffer, client->write_buffer_len);
 
-	if(written == -1 && errno == EAGAIN) {
-		return 0;
-	} else if(written == -1) {
-		wlr_log(WLR_ERROR, "Unable to send data from queue to IPC client");
-		ipc_client_disconnect(client);
-		return 0;
+	struct nedm_ipc_handle *ipc = &client->server->ipc;
+	struct iovec iov[IPC_IOV_MAX];
+	int niov = 0;
+	if(client->partial != NULL) {
+		iov[niov].iov_base = client->partial + client->offset;
+		iov[niov].iov_len = client->partial_len - client->offset;
+		++niov;
+	}
+	uint64_t end = client->cursor;
+	for(; end < ipc->ring_head && niov < IPC_IOV_MAX; ++end) {
+		if(ipc_client_delivery(client, end) != IPC_DELIVER) {
+			continue;
+		}
+		struct nedm_ipc_slot *slot = &ipc->ring[end % NEDM_IPC_RING_SIZE];
+		size_t offset = end == client->cursor && client->partial == NULL
+		                    ? client->offset
+		                    : 0;
+		iov[niov].iov_base = slot->data + offset;
+		iov[niov].iov_len = slot->len - offset;
+		++niov;
+	}
+
+	ssize_t written = 0;
+	if(niov > 0) {
+		written = writev(client->fd, iov, niov);
+		if(written == -1 && errno == EAGAIN) {
+			return 0;
+		} else if(written == -1) {
+			wlr_log(WLR_ERROR, "Unable to send data from queue to IPC client");
+			ipc_client_disconnect(client);
+			return 0;
+		}
 	}
 
-	memmove(client->write_buffer, client->write_buffer + written,
-	        client->write_buffer_len - written);
-	client->write_buffer_len -= written;
+	if(client->partial != NULL) {
+		size_t remaining = client->partial_len - client->offset;
+		if((size_t)written < remaining) {
+			client->offset += written;
+			return 0;
+		}
+		written -= remaining;
+		free(client->partial);
+		client->partial = NULL;
+		client->offset = 0;
+	}
+
+	/* Release the events which were sent completely or skipped */
+	while(client->cursor < end) {
+		enum ipc_delivery delivery =
+		    ipc_client_delivery(client, client->cursor);
+		if(delivery == IPC_DELIVER) {
+			struct nedm_ipc_slot *slot =
+			    &ipc->ring[client->cursor % NEDM_IPC_RING_SIZE];
+			size_t remaining = slot->len - client->offset;
+			if((size_t)written < remaining) {
+				client->offset += written;
+				break;
+			}
+			written -= remaining;
+		} else if(delivery == IPC_COALESCE) {
+			++client->coalesced;
+		}
+		ipc_client_advance(client);
+	}
 
-	if(client->write_buffer_len == 0 && client->writable_event_source) {
+	if(client->cursor == ipc->ring_head && client->writable_event_source) {
 		wl_event_source_remove(client->writable_event_source);
 		client->writable_event_source = NULL;
 	}
@@ -197,22 +414,26 @@ ipc_handle_connection(int fd, uint32_t mask, void *data) {
 	client->read_discard = 0;
 	client->server = server;
 	client->fd = client_fd;
+	client->subscriptions = NEDM_IPC_EVENT_MASK_ALL;
+	client->cursor = ipc->ring_head;
+	client->offset = 0;
+	client->policy = NEDM_IPC_POLICY_DISCONNECT;
+	client->partial = NULL;
+	client->partial_len = 0;
+	client->dropped = 0;
+	client->coalesced = 0;
+	client->reported_dropped = 0;
+	client->reported_coalesced = 0;
+	client->stats_pending = false;
 	client->event_source =
 	    wl_event_loop_add_fd(server->event_loop, client_fd, WL_EVENT_READABLE,
 	                         ipc_client_handle_readable, client);
-	client->writable_event_source =
-	    wl_event_loop_add_fd(server->event_loop, client_fd, WL_EVENT_WRITABLE,
-	                         ipc_client_handle_writable, client);
-
-	client->write_buffer_size = 128;
-	client->write_buffer_len = 0;
-	client->write_buffer = malloc(client->write_buffer_size);
-	if(!client->write_buffer) {
-		wlr_log(WLR_ERROR, "Unable to allocate ipc client write buffer");
-		close(client_fd);
-		return 0;
-	}
+	client->writable_event_source = NULL;
 
+	if(wl_list_empty(&ipc->client_list)) {
+		wl_event_source_timer_update(ipc->stats_timer,
+		                             NEDM_IPC_STATS_INTERVAL);
+	}
 	wl_list_insert(&ipc->client_list, &client->link);
 	return 0;
 }
@@ -282,14 +503,19 @@ ipc_client_disconnect(struct nedm_ipc_client *client) {
 
 	shutdown(client->fd, SHUT_RDWR);
 
+	if(client->server->ipc.current_client == client) {
+		client->server->ipc.current_client = NULL;
+	}
+
 	wl_event_source_remove(client->event_source);
 	if(client->writable_event_source) {
 		wl_event_source_remove(client->writable_event_source);
 	}
 	wl_list_remove(&client->link);
-	if(client->write_buffer != NULL) {
-		free(client->write_buffer);
+	while(client->cursor < client->server->ipc.ring_head) {
+		ipc_client_advance(client);
 	}
+	free(client->partial);
 	if(client->read_buffer != NULL) {
 		free(client->read_buffer);
 	}
@@ -297,6 +523,184 @@ ipc_client_disconnect(struct nedm_ipc_client *client) {
 	free(client);
 }
 
+/* Returns a copy of str which can be used inside a JSON string */
+static char *
+ipc_json_escape(const char *str) {
+	char *escaped = malloc(6 * strlen(str) + 1);
+	if(escaped == NULL) {
+		return NULL;
+	}
+	char *pos = escaped;
+	for(; *str != '\0'; ++str) {
+		unsigned char c = *str;
+		if(c == '"' || c == '\\') {
+			*pos++ = '\\';
+			*pos++ = c;
+		} else if(c < 0x20) {
+			pos += sprintf(pos, "\\u%04x", c);
+		} else {
+			*pos++ = c;
+		}
+	}
+	*pos = '\0';
+	return escaped;
+}
+
+static bool
+ipc_request_id_valid(const char *id) {
+	size_t len = strlen(id);
+	if(len == 0 || len > IPC_REQUEST_ID_MAX) {
+		return false;
+	}
+	for(; *id != '\0'; ++id) {
+		if(!isalnum((unsigned char)*id) && strchr("_-.:", *id) == NULL) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Splits the commands of a request at every ';' which is not escaped by a
+ * backslash. Returns the number of commands. */
+static uint32_t
+ipc_request_split(char *commands, char ***split) {
+	uint32_t ncommands = 1;
+	for(char *pos = commands; *pos != '\0'; ++pos) {
+		if(*pos == '\\' && pos[1] == ';') {
+			++pos;
+		} else if(*pos == ';') {
+			++ncommands;
+		}
+	}
+	*split = calloc(ncommands, sizeof(char *));
+	if(*split == NULL) {
+		return 0;
+	}
+	uint32_t i = 0;
+	char *out = commands;
+	(*split)[i++] = out;
+	for(char *pos = commands; *pos != '\0'; ++pos) {
+		if(*pos == '\\' && pos[1] == ';') {
+			*out++ = *++pos;
+		} else if(*pos == ';') {
+			*out++ = '\0';
+			(*split)[i++] = out;
+		} else {
+			*out++ = *pos;
+		}
+	}
+	*out = '\0';
+	return ncommands;
+}
+
+/* Runs a command of a request, returns a JSON object describing its result */
+static char *
+ipc_request_run(struct nedm_ipc_client *client, char *command, int *status) {
+	struct nedm_server *server = client->server;
+	char *errstr = NULL;
+	*status = 0;
+	command += strspn(command, " ");
+	if(*command == '\0') {
+		errstr = strdup("Empty command");
+		*status = -1;
+	} else if(parse_rc_line(server, command, &errstr, status) != 0) {
+		*status = -1;
+	} else if(*status != 0) {
+		errstr = strdup("Command failed");
+	}
+	if(server->ipc.current_client != client) {
+		/* The client was disconnected by the command */
+		free(errstr);
+		return NULL;
+	}
+
+	char *result;
+	if(*status == 0) {
+		result = strdup("{\"status\":0}");
+	} else {
+		char *escaped = ipc_json_escape(errstr != NULL ? errstr : "");
+		result = malloc_vsprintf("{\"status\":%d,\"error\":\"%s\"}",
+		                         *status, escaped != NULL ? escaped : "");
+		free(escaped);
+	}
+	free(errstr);
+	return result;
+}
+
+/* Runs a request of the form "<id> <command>[;<command>...]" and sends a single
+ * reply containing the result of every command to the client. All commands
+ * are run in the same iteration of the event loop, so that layout changes are
+ * applied and outputs are committed only once. Returns -1 if the client was
+ * disconnected. */
+static int
+ipc_client_handle_request(struct nedm_ipc_client *client, char *request) {
+	struct nedm_server *server = client->server;
+	char *saveptr;
+	char *id = strtok_r(request, " ", &saveptr);
+	char *commands = strtok_r(NULL, "", &saveptr);
+	if(id == NULL || !ipc_request_id_valid(id)) {
+		wlr_log(WLR_ERROR, "Invalid id in IPC request");
+		ipc_send_reply(client, NEDM_IPC_EVENT_REPLY,
+		               "{\"event_name\":\"reply\",\"id\":null,"
+		               "\"success\":0,\"results\":[]}");
+		return server->ipc.current_client == client ? 0 : -1;
+	}
+
+	char **split = NULL;
+	uint32_t ncommands =
+	    commands == NULL ? 0 : ipc_request_split(commands, &split);
+	char **results = calloc(ncommands + 1, sizeof(char *));
+	if(results == NULL) {
+		wlr_log(WLR_ERROR, "Unable to allocate memory for IPC request");
+		free(split);
+		return 0;
+	}
+
+	message_clear(server->curr_output);
+	bool success = ncommands > 0;
+	size_t results_len = 0;
+	for(uint32_t i = 0; i < ncommands; ++i) {
+		int status;
+		results[i] = ipc_request_run(client, split[i], &status);
+		if(server->ipc.current_client != client) {
+			for(uint32_t j = 0; j < i; ++j) {
+				free(results[j]);
+			}
+			free(results);
+			free(split);
+			return -1;
+		}
+		if(status != 0 || results[i] == NULL) {
+			success = false;
+		}
+		results_len += results[i] != NULL ? strlen(results[i]) + 1 : 0;
+	}
+	free(split);
+
+	/* Join the results with commas */
+	char *results_str = calloc(results_len + 1, sizeof(char));
+	if(results_str != NULL) {
+		char *pos = results_str;
+		for(uint32_t i = 0; i < ncommands; ++i) {
+			if(results[i] != NULL) {
+				pos += sprintf(pos, "%s%s", pos == results_str ? "" : ",",
+				               results[i]);
+			}
+		}
+	}
+	for(uint32_t i = 0; i < ncommands; ++i) {
+		free(results[i]);
+	}
+	free(results);
+
+	ipc_send_reply(client, NEDM_IPC_EVENT_REPLY,
+	               "{\"event_name\":\"reply\",\"id\":\"%s\",\"success\":%d,"
+	               "\"results\":[%s]}",
+	               id, success, results_str != NULL ? results_str : "");
+	free(results_str);
+	return server->ipc.current_client == client ? 0 : -1;
+}
+
 void
 ipc_client_handle_command(struct nedm_ipc_client *client) {
 	if(client == NULL) {
@@ -313,10 +717,26 @@ ipc_client_handle_command(struct nedm_ipc_client *client) {
 		} else {
 			*nl_pos = '\0';
 			char *line = client->read_buffer + offset;
-			if(*line != '\0' && *line != '#') {
+			struct nedm_ipc_handle *ipc = &client->server->ipc;
+			if(strncmp(line, "request ", strlen("request ")) == 0) {
+				ipc->current_client = client;
+				if(ipc_client_handle_request(
+				       client, line + strlen("request ")) != 0) {
+					return;
+				}
+				ipc->current_client = NULL;
+			} else if(*line != '\0' && *line != '#') {
 				message_clear(client->server->curr_output);
-				char *errstr;
-				if(parse_rc_line(client->server, line, &errstr) != 0) {
+				char *errstr = NULL;
+				ipc->current_client = client;
+				int ret = parse_rc_line(client->server, line, &errstr, NULL);
+				if(ipc->current_client != client) {
+					/* The client was disconnected by the command */
+					free(errstr);
+					return;
+				}
+				ipc->current_client = NULL;
+				if(ret != 0) {
 					if(errstr != NULL) {
 						message_printf(client->server->curr_output, "%s",
 						               errstr);
@@ -336,71 +756,201 @@ ipc_client_handle_command(struct nedm_ipc_client *client) {
 	client->read_buf_len -= offset;
 }
 
-void
-ipc_send_event_client(struct nedm_ipc_client *client, const char *payload,
-                      uint32_t payload_length) {
-	char data[IPC_HEADER_SIZE];
+int
+ipc_event_from_str(const char *name) {
+	for(int i = 0; i < NEDM_IPC_EVENT_COUNT; ++i) {
+		if(strcmp(ipc_event_string[i], name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
 
-	memcpy(data, ipc_magic, sizeof(ipc_magic));
+/* Sets the events sent to the client whose command is being run */
+int
+ipc_subscribe(struct nedm_server *server, uint64_t subscriptions) {
+	struct nedm_ipc_client *client = server->ipc.current_client;
+	if(client == NULL) {
+		wlr_log(WLR_ERROR, "\"subscribe\" can only be used over the socket");
+		return -1;
+	}
+	client->subscriptions = subscriptions;
+	return 0;
+}
 
-	// +1 for terminating null character
-	while(client->write_buffer_len + IPC_HEADER_SIZE + payload_length + 1 >=
-	      client->write_buffer_size) {
-		client->write_buffer_size *= 2;
+/* Returns whether any client is subscribed to the event. Events nobody listens
+ * to are not even formatted. */
+bool
+ipc_event_subscribed(struct nedm_server *server, enum nedm_ipc_event event) {
+	if(server->enable_socket == false) {
+		return false;
+	}
+	struct nedm_ipc_client *it;
+	wl_list_for_each(it, &server->ipc.client_list, link) {
+		if(it->subscriptions & NEDM_IPC_EVENT_MASK(event)) {
+			return true;
+		}
 	}
+	return false;
+}
 
-	if(client->write_buffer_size > 4e6) { // 4 MB
-		wlr_log(WLR_ERROR,
-		        "Client write buffer too big (%zu), disconnecting client",
-		        client->write_buffer_size);
-		ipc_client_disconnect(client);
+/* Marks the last pending state event of the same type for the output as
+ * superseded by the event in slot seq */
+static void
+ipc_supersede_state(struct nedm_ipc_handle *ipc, uint64_t seq) {
+	struct nedm_ipc_slot *slot = &ipc->ring[seq % NEDM_IPC_RING_SIZE];
+	/* Sequence numbers in the chain are offset by one, 0 ends the chain */
+	slot->prev = ipc->last_state[slot->event];
+	ipc->last_state[slot->event] = seq + 1;
+	for(uint64_t prev = slot->prev; prev > ipc->ring_tail;) {
+		struct nedm_ipc_slot *prev_slot =
+		    &ipc->ring[(prev - 1) % NEDM_IPC_RING_SIZE];
+		if(prev_slot->output != NULL &&
+		   strcmp(prev_slot->output, slot->output) == 0) {
+			prev_slot->superseded = true;
+			return;
+		}
+		prev = prev_slot->prev;
+	}
+}
+
+static void
+ipc_send_event_va_list(struct nedm_server *server,
+                       struct nedm_ipc_client *recipient,
+                       enum nedm_ipc_event event, const char *output,
+                       const char *fmt, va_list args) {
+	char *msg = malloc_vsprintf_va_list(fmt, args);
+	if(msg == NULL) {
+		wlr_log(WLR_ERROR, "Unable to allocate memory for ipc event");
 		return;
 	}
 
-	char *new_buffer = realloc(client->write_buffer, client->write_buffer_size);
-	if(!new_buffer) {
-		wlr_log(WLR_ERROR, "Unable to reallocate ipc client write buffer");
-		ipc_client_disconnect(client);
+	/* Serialize the event once, including header and null character */
+	size_t len = IPC_HEADER_SIZE + strlen(msg) + 1;
+	char *data = malloc(len);
+	if(data == NULL) {
+		wlr_log(WLR_ERROR, "Unable to allocate memory for ipc event");
+		free(msg);
 		return;
 	}
-	client->write_buffer = new_buffer;
+	memcpy(data, ipc_magic, IPC_HEADER_SIZE);
+	memcpy(data + IPC_HEADER_SIZE, msg, len - IPC_HEADER_SIZE);
+	free(msg);
+
+	struct nedm_ipc_handle *ipc = &server->ipc;
+	struct nedm_ipc_client *it, *tmp;
+	/* Clients still holding the oldest slot of a full ring are too slow */
+	if(ipc->ring_head - ipc->ring_tail == NEDM_IPC_RING_SIZE) {
+		uint64_t tail = ipc->ring_tail;
+		wl_list_for_each_safe(it, tmp, &ipc->client_list, link) {
+			if(it->cursor != tail) {
+				continue;
+			}
+			if(it->policy == NEDM_IPC_POLICY_DISCONNECT ||
+			   ipc_client_drop_oldest(it) != 0) {
+				wlr_log(WLR_ERROR,
+				        "IPC client lags %" PRIu64
+				        " events behind, disconnecting client",
+				        ipc->ring_head - it->cursor);
+				ipc_client_disconnect(it);
+			}
+		}
+	}
 
-	memcpy(client->write_buffer + client->write_buffer_len, data,
-	       IPC_HEADER_SIZE);
-	client->write_buffer_len += IPC_HEADER_SIZE;
-	memcpy(client->write_buffer + client->write_buffer_len, payload,
-	       payload_length);
-	client->write_buffer_len += payload_length;
-	memcpy(client->write_buffer + client->write_buffer_len, "\0", 1);
-	client->write_buffer_len += 1;
+	++ipc->emitted[event];
+	uint64_t seq = ipc->ring_head;
+	struct nedm_ipc_slot *slot = &ipc->ring[seq % NEDM_IPC_RING_SIZE];
+	slot->data = data;
+	slot->len = len;
+	slot->event = event;
+	slot->refcount = 1; // Held until the slot is published
+	slot->recipient = recipient;
+	slot->output = NULL;
+	slot->superseded = false;
+	++ipc->ring_head;
+	if(output != NULL) {
+		slot->output = strdup(output);
+		if(slot->output != NULL) {
+			ipc_supersede_state(ipc, seq);
+		}
+	}
+	wl_list_for_each(it, &ipc->client_list, link) {
+		/* Clients which are up to date skip the event right away */
+		if(it->cursor == seq && it->partial == NULL &&
+		   ipc_client_delivery(it, seq) != IPC_DELIVER) {
+			++it->cursor;
+			continue;
+		}
+		++slot->refcount;
+		if(it->writable_event_source == NULL) {
+			it->writable_event_source = wl_event_loop_add_fd(
+			    server->event_loop, it->fd, WL_EVENT_WRITABLE,
+			    ipc_client_handle_writable, it);
+		}
+	}
+	ipc_slot_unref(ipc, seq);
 }
 
 void
-ipc_send_event(struct nedm_server *server, const char *fmt, ...) {
-	if(server->enable_socket == false) {
+ipc_send_event(struct nedm_server *server, enum nedm_ipc_event event,
+               const char *fmt, ...) {
+	if(!ipc_event_subscribed(server, event)) {
 		return;
 	}
-	if(wl_list_empty(&server->ipc.client_list)) {
+	va_list args;
+	va_start(args, fmt);
+	ipc_send_event_va_list(server, NULL, event, NULL, fmt, args);
+	va_end(args);
+}
+
+/* Sends an event describing the current state of the output. Clients using
+ * the coalesce policy only receive the latest such event of each type per
+ * output if they lag behind. */
+void
+ipc_send_state_event(struct nedm_server *server, enum nedm_ipc_event event,
+                     const char *output, const char *fmt, ...) {
+	if(!ipc_event_subscribed(server, event)) {
 		return;
 	}
 	va_list args;
 	va_start(args, fmt);
-	char *msg = malloc_vsprintf_va_list(fmt, args);
-	if(msg == NULL) {
-		wlr_log(WLR_ERROR, "Unable to allocate memory for ipc event");
-		va_end(args);
+	ipc_send_event_va_list(server, NULL, event, output, fmt, args);
+	va_end(args);
+}
+
+/* Sends the answer to a request or query to a single client, independently
+ * of the events the client subscribed to */
+void
+ipc_send_reply(struct nedm_ipc_client *client, enum nedm_ipc_event event,
+               const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	ipc_send_event_va_list(client->server, client, event, NULL, fmt, args);
+	va_end(args);
+}
+
+/* Sends an event to a single client */
+void
+ipc_send_client_event(struct nedm_ipc_client *client,
+                      enum nedm_ipc_event event, const char *fmt, ...) {
+	if(!(client->subscriptions & NEDM_IPC_EVENT_MASK(event))) {
 		return;
 	}
+	va_list args;
+	va_start(args, fmt);
+	ipc_send_event_va_list(client->server, client, event, NULL, fmt, args);
 	va_end(args);
-	struct nedm_ipc_client *it, *tmp;
-	uint32_t len = strlen(msg);
-	wl_list_for_each_safe(it, tmp, &server->ipc.client_list, link) {
-		if(it->writable_event_source == NULL) {
-			it->writable_event_source = wl_event_loop_add_fd(
-			    server->event_loop, it->fd, WL_EVENT_WRITABLE,
-			    ipc_client_handle_writable, it);
-		}
-		ipc_send_event_client(it, msg, len);
+}
+
+/* Sets what happens to the client whose command is being run if it lags too
+ * far behind */
+int
+ipc_set_policy(struct nedm_server *server, enum nedm_ipc_policy policy) {
+	struct nedm_ipc_client *client = server->ipc.current_client;
+	if(client == NULL) {
+		wlr_log(WLR_ERROR, "\"ipc_policy\" can only be used over the socket");
+		return -1;
 	}
-	free(msg);
+	client->policy = policy;
+	return 0;
 }
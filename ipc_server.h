@@ -6,12 +6,96 @@
 
 #include "config.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <wayland-server-core.h>
 
 struct nedm_server;
 
+/* All events which may be sent over the socket, clients can subscribe to any
+ * subset of them */
+#define FOREACH_IPC_EVENT(EVENT)                                               \
+	EVENT(NEDM_IPC_EVENT_ADAPTIVE_SYNC, adaptive_sync)                         \
+	EVENT(NEDM_IPC_EVENT_BACKGROUND, background)                               \
+	EVENT(NEDM_IPC_EVENT_CLOSE, close)                                         \
+	EVENT(NEDM_IPC_EVENT_CONFIGURE_INPUT, configure_input)                     \
+	EVENT(NEDM_IPC_EVENT_CONFIGURE_MESSAGE, configure_message)                 \
+	EVENT(NEDM_IPC_EVENT_CONFIGURE_OUTPUT, configure_output)                   \
+	EVENT(NEDM_IPC_EVENT_CONFIGURE_WALLPAPER, configure_wallpaper)             \
+	EVENT(NEDM_IPC_EVENT_CURSOR_SWITCH_TILE, cursor_switch_tile)               \
+	EVENT(NEDM_IPC_EVENT_CUSTOM_EVENT, custom_event)                           \
+	EVENT(NEDM_IPC_EVENT_CYCLE_OUTPUTS, cycle_outputs)                         \
+	EVENT(NEDM_IPC_EVENT_CYCLE_VIEWS, cycle_views)                             \
+	EVENT(NEDM_IPC_EVENT_DEFINEKEY, definekey)                                 \
+	EVENT(NEDM_IPC_EVENT_DEFINEMODE, definemode)                               \
+	EVENT(NEDM_IPC_EVENT_DESTROY_OUTPUT, destroy_output)                       \
+	EVENT(NEDM_IPC_EVENT_DUMP, dump)                                           \
+	EVENT(NEDM_IPC_EVENT_FOCUS_TILE, focus_tile)                               \
+	EVENT(NEDM_IPC_EVENT_FRAME_STATS, frame_stats)                             \
+	EVENT(NEDM_IPC_EVENT_FULLSCREEN, fullscreen)                               \
+	EVENT(NEDM_IPC_EVENT_GET, get)                                             \
+	EVENT(NEDM_IPC_EVENT_IPC_STATS, ipc_stats)                                 \
+	EVENT(NEDM_IPC_EVENT_MERGE_TILE, merge_tile)                               \
+	EVENT(NEDM_IPC_EVENT_MOVE_VIEW, move_view)                                 \
+	EVENT(NEDM_IPC_EVENT_MOVE_VIEW_TO_CYCLE_OUTPUT, move_view_to_cycle_output) \
+	EVENT(NEDM_IPC_EVENT_NEW_OUTPUT, new_output)                               \
+	EVENT(NEDM_IPC_EVENT_REPLY, reply)                                         \
+	EVENT(NEDM_IPC_EVENT_RESIZE_TILE, resize_tile)                             \
+	EVENT(NEDM_IPC_EVENT_SCANOUT, scanout)                                     \
+	EVENT(NEDM_IPC_EVENT_SET_NWS, set_nws)                                     \
+	EVENT(NEDM_IPC_EVENT_SPLIT, split)                                         \
+	EVENT(NEDM_IPC_EVENT_SWAP_TILE, swap_tile)                                 \
+	EVENT(NEDM_IPC_EVENT_SWITCH_DEFAULT_MODE, switch_default_mode)             \
+	EVENT(NEDM_IPC_EVENT_SWITCH_OUTPUT, switch_output)                         \
+	EVENT(NEDM_IPC_EVENT_SWITCH_WS, switch_ws)                                 \
+	EVENT(NEDM_IPC_EVENT_VIEW_MAP, view_map)                                   \
+	EVENT(NEDM_IPC_EVENT_VIEW_UNMAP, view_unmap)
+
+#define GENERATE_IPC_EVENT_ENUM(ENUM, NAME) ENUM,
+#define GENERATE_IPC_EVENT_STRING(ENUM, NAME) #NAME,
+
+enum nedm_ipc_event {
+	FOREACH_IPC_EVENT(GENERATE_IPC_EVENT_ENUM) NEDM_IPC_EVENT_COUNT
+};
+
+extern const char *ipc_event_string[];
+
+/* Number of events buffered for clients which have not read them yet. A
+ * client lagging this many events behind is considered too slow. */
+#define NEDM_IPC_RING_SIZE 1024
+
+/* Interval in milliseconds at which clients are told how many events they
+ * lost */
+#define NEDM_IPC_STATS_INTERVAL 10000
+
+/* What happens to a client which lags NEDM_IPC_RING_SIZE events behind */
+enum nedm_ipc_policy {
+	NEDM_IPC_POLICY_DISCONNECT,
+	NEDM_IPC_POLICY_DROP_OLDEST,
+	NEDM_IPC_POLICY_COALESCE, // Drop superseded state events, then oldest
+	NEDM_IPC_POLICY_NOPT
+};
+
+#define NEDM_IPC_EVENT_MASK(event) ((uint64_t)1 << (event))
+#define NEDM_IPC_EVENT_MASK_ALL                                                \
+	((uint64_t)-1 >> (64 - NEDM_IPC_EVENT_COUNT))
+
+/* An event serialized once and shared by all clients it is sent to */
+struct nedm_ipc_slot {
+	char *data; // Header, payload and terminating null character
+	size_t len;
+	enum nedm_ipc_event event;
+	uint32_t refcount; // Number of clients which have not passed the slot
+	struct nedm_ipc_client *recipient; // NULL if sent to all clients
+	/* Output described by a state event, NULL for other events */
+	char *output;
+	/* Sequence number plus one of the previous state event of the same
+	 * type, 0 if there is none */
+	uint64_t prev;
+	bool superseded; // A newer state event for the same output exists
+};
+
 struct nedm_ipc_client {
 	struct wl_event_source *event_source;
 	struct wl_event_source *writable_event_source;
@@ -19,9 +103,21 @@ struct nedm_ipc_client {
 	struct wl_list link;
 	int fd;
 	uint32_t security_policy;
-	size_t write_buffer_len;
-	size_t write_buffer_size;
-	char *write_buffer;
+	uint64_t subscriptions; // Bitmask of the events sent to the client
+	/* Sequence number of the next event to send. The client holds a
+	 * reference on every slot from cursor up to the head of the ring. */
+	uint64_t cursor;
+	size_t offset; // Bytes of the event at cursor which were already sent
+	enum nedm_ipc_policy policy;
+	/* Rest of an event whose slot was dropped while it was being sent. As
+	 * long as it is set, offset refers to it. */
+	char *partial;
+	size_t partial_len;
+	uint64_t dropped;   // Events lost because the client lagged behind
+	uint64_t coalesced; // State events skipped in favour of newer ones
+	uint64_t reported_dropped;
+	uint64_t reported_coalesced;
+	bool stats_pending; // The client is due an ipc_stats event
 	// The following is for storing data between event_loop calls
 	uint16_t read_buf_len;
 	size_t read_buf_cap;
@@ -35,10 +131,39 @@ struct nedm_ipc_handle {
 	struct wl_list client_list;
 	struct wl_listener display_destroy;
 	struct sockaddr_un *sockaddr;
+	/* Events pending for at least one client, indexed by sequence number
+	 * modulo NEDM_IPC_RING_SIZE */
+	struct nedm_ipc_slot *ring;
+	uint64_t ring_head; // Sequence number of the next event
+	uint64_t ring_tail; // Sequence number of the oldest pending event
+	/* The client whose command is currently being run, if any */
+	struct nedm_ipc_client *current_client;
+	uint64_t emitted[NEDM_IPC_EVENT_COUNT]; // Events sent per type
+	/* Sequence number plus one of the latest state event per type */
+	uint64_t last_state[NEDM_IPC_EVENT_COUNT];
+	struct wl_event_source *stats_timer;
 };
 
 void
-ipc_send_event(struct nedm_server *server, const char *fmt, ...);
+ipc_send_event(struct nedm_server *server, enum nedm_ipc_event event,
+               const char *fmt, ...);
+void
+ipc_send_state_event(struct nedm_server *server, enum nedm_ipc_event event,
+                     const char *output, const char *fmt, ...);
+void
+ipc_send_client_event(struct nedm_ipc_client *client,
+                      enum nedm_ipc_event event, const char *fmt, ...);
+void
+ipc_send_reply(struct nedm_ipc_client *client, enum nedm_ipc_event event,
+               const char *fmt, ...);
+bool
+ipc_event_subscribed(struct nedm_server *server, enum nedm_ipc_event event);
+int
+ipc_event_from_str(const char *name);
+int
+ipc_subscribe(struct nedm_server *server, uint64_t subscriptions);
+int
+ipc_set_policy(struct nedm_server *server, enum nedm_ipc_policy policy);
 int
 ipc_init(struct nedm_server *server);
 int
@@ -50,7 +175,5 @@ void
 ipc_client_disconnect(struct nedm_ipc_client *client);
 void
 ipc_client_handle_command(struct nedm_ipc_client *client);
-// bool ipc_send_reply(struct ipc_client *client, const char *payload, uint32_t
-// payload_length);
 
 #endif
@@ -3,6 +3,7 @@
 
 #define _POSIX_C_SOURCE 200809L
 
+#include <inttypes.h>
 #include <signal.h>
 #include <string.h>
 #include <sys/wait.h>
@@ -46,17 +47,96 @@ keybinding_resize(struct keybinding_list *list) {
 	return 0;
 }
 
+static uint32_t
+keybinding_hash(xkb_mod_mask_t modifiers, xkb_keysym_t key) {
+	/* Mix both values (multiplicative hashing with odd 32 bit constants) */
+	uint32_t h = key * 0x9e3779b1u;
+	h ^= (modifiers + 0x7f4a7c15u) * 0x85ebca6bu;
+	h ^= h >> 16;
+	return h;
+}
+
+static bool
+keybinding_matches(const struct keybinding *a, const struct keybinding *b) {
+	return !(a->modifiers ^ b->modifiers) && a->mode == b->mode &&
+	       a->key == b->key;
+}
+
+/* Returns the slot in which the keybinding is stored or the empty slot in
+ * which it would have to be inserted. The index must not be full. */
+static uint32_t *
+keybinding_index_slot(const struct keybinding_list *list,
+                      const struct keybinding_index *index,
+                      const struct keybinding *keybinding) {
+	uint32_t mask = index->capacity - 1;
+	uint32_t pos = keybinding_hash(keybinding->modifiers, keybinding->key);
+	for(;; ++pos) {
+		uint32_t *slot = &index->slots[pos & mask];
+		if(*slot == 0 ||
+		   keybinding_matches(list->keybindings[*slot - 1], keybinding)) {
+			return slot;
+		}
+	}
+}
+
+static int
+keybinding_index_grow(const struct keybinding_list *list,
+                      struct keybinding_index *index) {
+	uint32_t new_capacity = index->capacity == 0 ? 8 : index->capacity * 2;
+	uint32_t *new_slots = calloc(new_capacity, sizeof(uint32_t));
+	if(new_slots == NULL) {
+		return -1;
+	}
+	struct keybinding_index new_index = {.length = index->length,
+	                                     .capacity = new_capacity,
+	                                     .slots = new_slots};
+	for(uint32_t i = 0; i < index->capacity; ++i) {
+		if(index->slots[i] != 0) {
+			*keybinding_index_slot(
+			    list, &new_index,
+			    list->keybindings[index->slots[i] - 1]) = index->slots[i];
+		}
+	}
+	free(index->slots);
+	*index = new_index;
+	return 0;
+}
+
+/* Get the index for the given mode, allocating it if necessary */
+static struct keybinding_index *
+keybinding_list_get_index(struct keybinding_list *list, uint16_t mode) {
+	if(mode >= list->nindices) {
+		/* Computed in 32 bits, since it does not fit into the mode for
+		 * UINT16_MAX */
+		uint32_t nindices = (uint32_t)mode + 1;
+		struct keybinding_index *new_indices = realloc(
+		    list->indices, sizeof(struct keybinding_index) * nindices);
+		if(new_indices == NULL) {
+			return NULL;
+		}
+		memset(new_indices + list->nindices, 0,
+		       sizeof(struct keybinding_index) * (nindices - list->nindices));
+		list->indices = new_indices;
+		list->nindices = nindices;
+	}
+	return &list->indices[mode];
+}
+
 struct keybinding **
 find_keybinding(const struct keybinding_list *list,
                 const struct keybinding *keybinding) {
-	struct keybinding **it = list->keybindings;
-	for(size_t i = 0; i < list->length; ++i, ++it) {
-		if(!(keybinding->modifiers ^ (*it)->modifiers) &&
-		   keybinding->mode == (*it)->mode && keybinding->key == (*it)->key) {
-			return it;
-		}
+	if(keybinding->mode >= list->nindices) {
+		return NULL;
 	}
-	return NULL;
+	const struct keybinding_index *index = &list->indices[keybinding->mode];
+	if(index->length == 0) {
+		return NULL;
+	}
+	uint32_t *slot = keybinding_index_slot(list, index, keybinding);
+	if(*slot == 0) {
+		return NULL;
+	}
+	return &list->keybindings[*slot - 1];
 }
 
 void
@@ -93,6 +173,15 @@ keybinding_free(struct keybinding *keybinding, bool recursive) {
 		}
 		free(keybinding->data.m_cfg);
 		break;
+	case KEYBINDING_CONFIGURE_WALLPAPER:
+		if(keybinding->data.wp_cfg->image_path != NULL) {
+			free(keybinding->data.wp_cfg->image_path);
+		}
+		if(keybinding->data.wp_cfg->slideshow != NULL) {
+			free(keybinding->data.wp_cfg->slideshow);
+		}
+		free(keybinding->data.wp_cfg);
+		break;
 	case KEYBINDING_DISPLAY_MESSAGE:
 		if(keybinding->data.c != NULL) {
 			free(keybinding->data.c);
@@ -125,16 +214,29 @@ keybinding_list_push(struct keybinding_list *list,
 		return -1;
 	}
 
+	struct keybinding_index *index =
+	    keybinding_list_get_index(list, keybinding->mode);
+	if(index == NULL) {
+		return -1;
+	}
+	/* Keep the load factor of the index below 1/2 */
+	if(2 * (index->length + 1) > index->capacity &&
+	   keybinding_index_grow(list, index) != 0) {
+		return -1;
+	}
+
 	/*Maintain that only a single keybinding for a key, modifier and mode may
 	 * exist*/
-	struct keybinding **found_keybinding = find_keybinding(list, keybinding);
-	if(found_keybinding != NULL) {
-		keybinding_free(*found_keybinding, true);
-		*found_keybinding = keybinding;
+	uint32_t *slot = keybinding_index_slot(list, index, keybinding);
+	if(*slot != 0) {
+		keybinding_free(list->keybindings[*slot - 1], true);
+		list->keybindings[*slot - 1] = keybinding;
 		wlr_log(WLR_DEBUG, "A keybinding was found twice in the config file.");
 	} else {
 		list->keybindings[list->length] = keybinding;
 		++list->length;
+		*slot = list->length;
+		++index->length;
 	}
 	return 0;
 }
@@ -145,6 +247,8 @@ keybinding_list_init(void) {
 	list->keybindings = malloc(sizeof(struct keybinding *));
 	list->capacity = 1;
 	list->length = 0;
+	list->nindices = 0;
+	list->indices = NULL;
 	return list;
 }
 
@@ -156,6 +260,10 @@ keybinding_list_free(struct keybinding_list *list) {
 	for(unsigned int i = 0; i < list->length; ++i) {
 		keybinding_free(list->keybindings[i], true);
 	}
+	for(uint32_t i = 0; i < list->nindices; ++i) {
+		free(list->indices[i].slots);
+	}
+	free(list->indices);
 	free(list->keybindings);
 	free(list);
 }
@@ -227,70 +335,22 @@ output_from_num(struct nedm_server *server, int num) {
 
 struct nedm_tile *
 find_right_tile(const struct nedm_tile *tile) {
-	struct nedm_tile *it = tile->next;
-	int center = tile->tile.y + tile->tile.height / 2;
-	while(it != tile) {
-		if(it->tile.x == tile->tile.x + tile->tile.width) {
-			if(is_between_strict(it->tile.y, it->tile.y + it->tile.height,
-			                     center) ||
-			   it->tile.y + it->tile.height == center) {
-				return it;
-			}
-		}
-		it = it->next;
-	}
-	return NULL;
+	return workspace_tile_neighbour(tile, NEDM_TILE_RIGHT);
 }
 
 struct nedm_tile *
 find_left_tile(const struct nedm_tile *tile) {
-	struct nedm_tile *it = tile->next;
-	int center = tile->tile.y + tile->tile.height / 2;
-	while(it != tile) {
-		if(it->tile.x + it->tile.width == tile->tile.x) {
-			if(is_between_strict(it->tile.y, it->tile.y + it->tile.height,
-			                     center) ||
-			   it->tile.y + it->tile.height == center) {
-				return it;
-			}
-		}
-		it = it->next;
-	}
-	return NULL;
+	return workspace_tile_neighbour(tile, NEDM_TILE_LEFT);
 }
 
 struct nedm_tile *
 find_top_tile(const struct nedm_tile *tile) {
-	struct nedm_tile *it = tile->next;
-	int center = tile->tile.x + tile->tile.width / 2;
-	while(it != tile) {
-		if(it->tile.y + it->tile.height == tile->tile.y) {
-			if(is_between_strict(it->tile.x, it->tile.x + it->tile.width,
-			                     center) ||
-			   it->tile.x + it->tile.width == center) {
-				return it;
-			}
-		}
-		it = it->next;
-	}
-	return NULL;
+	return workspace_tile_neighbour(tile, NEDM_TILE_TOP);
 }
 
 struct nedm_tile *
 find_bottom_tile(const struct nedm_tile *tile) {
-	struct nedm_tile *it = tile->next;
-	int center = tile->tile.x + tile->tile.width / 2;
-	while(it != tile) {
-		if(it->tile.y == tile->tile.y + tile->tile.height) {
-			if(is_between_strict(it->tile.x, it->tile.x + it->tile.width,
-			                     center) ||
-			   it->tile.x + it->tile.width == center) {
-				return it;
-			}
-		}
-		it = it->next;
-	}
-	return NULL;
+	return workspace_tile_neighbour(tile, NEDM_TILE_BOTTOM);
 }
 
 int *
@@ -343,18 +403,19 @@ merge_tile(struct nedm_tile *tile,
 		tile->workspace->server->seat->cursor_tile = tile;
 	}
 	free(merge_tile);
+	workspace_tiles_changed(tile->workspace);
 	if(tile->view != NULL) {
 		view_maximize(tile->view, tile);
 	}
 	ipc_send_event(
-	    tile->workspace->output->server,
+	    tile->workspace->output->server, NEDM_IPC_EVENT_MERGE_TILE,
 	    "{\"event_name\":\"merge_tile\",\"tile_id\":%d,\"merge_tile_id\":%d,"
 	    "\"workspace\":%d,\"output\":\"%s\",\"output_id\":%d}",
 	    tile->id, merge_tile_id, tile->workspace->num + 1,
 	    tile->workspace->output->name, output_get_num(tile->workspace->output));
 }
 
-void
+int
 keybinding_focus_tile(struct nedm_server *server, uint32_t tile_id);
 
 void
@@ -377,14 +438,14 @@ swap_tiles(struct nedm_tile *tile, struct nedm_tile *swap_tile, bool follow) {
 		        ->focused_tile->view);
 	}
 	ipc_send_event(
-	    tile->workspace->output->server,
+	    tile->workspace->output->server, NEDM_IPC_EVENT_SWAP_TILE,
 	    "{\"event_name\":\"swap_tile\",\"tile_id\":%d,\"swap_"
 	    "tile_id\":%d,\"workspace\":%d,\"output\":\"%s\",\"output_id\":%d}",
 	    tile->id, swap_tile->id, tile->workspace->num + 1,
 	    tile->workspace->output->name, output_get_num(tile->workspace->output));
 }
 
-void
+int
 swap_tile(struct nedm_server *server, uint32_t tile_id,
           struct nedm_tile *(*find_tile)(const struct nedm_tile *), bool follow) {
 	struct nedm_tile *tile = NULL;
@@ -395,10 +456,12 @@ swap_tile(struct nedm_server *server, uint32_t tile_id,
 	} else {
 		tile = tile_from_id(server, tile_id);
 	}
-	if(tile != NULL) {
-		struct nedm_tile *swap_tile = find_tile(tile);
-		swap_tiles(tile, swap_tile, follow);
+	if(tile == NULL) {
+		return -1;
 	}
+	struct nedm_tile *swap_tile = find_tile(tile);
+	swap_tiles(tile, swap_tile, follow);
+	return 0;
 }
 
 int *
@@ -441,24 +504,24 @@ merge_tile_bottom(struct nedm_tile *tile) {
 	merge_tile(tile, find_bottom_tile, get_width, get_x);
 }
 
-void
+int
 swap_tile_left(struct nedm_server *server, uint32_t tile_id, bool follow) {
-	swap_tile(server, tile_id, find_left_tile, follow);
+	return swap_tile(server, tile_id, find_left_tile, follow);
 }
 
-void
+int
 swap_tile_right(struct nedm_server *server, uint32_t tile_id, bool follow) {
-	swap_tile(server, tile_id, find_right_tile, follow);
+	return swap_tile(server, tile_id, find_right_tile, follow);
 }
 
-void
+int
 swap_tile_top(struct nedm_server *server, uint32_t tile_id, bool follow) {
-	swap_tile(server, tile_id, find_top_tile, follow);
+	return swap_tile(server, tile_id, find_top_tile, follow);
 }
 
-void
+int
 swap_tile_bottom(struct nedm_server *server, uint32_t tile_id, bool follow) {
-	swap_tile(server, tile_id, find_bottom_tile, follow);
+	return swap_tile(server, tile_id, find_bottom_tile, follow);
 }
 
 void
@@ -570,11 +633,12 @@ resize(struct nedm_tile *tile, const struct nedm_tile *parent, int coord_offset,
 	    old_height = tile->tile.height, old_width = tile->tile.width;
 	*get_coord(tile) += coord_offset;
 	*get_dim(tile) += dim_offset;
+	workspace_tiles_changed(tile->workspace);
 
 	if(tile->view != NULL) {
 		view_maximize(tile->view, tile);
 	}
-	ipc_send_event(tile->workspace->output->server,
+	ipc_send_event(tile->workspace->output->server, NEDM_IPC_EVENT_RESIZE_TILE,
 	               "{\"event_name\":\"resize_tile\",\"tile_id\":%d,\"old_"
 	               "dims\":\"[%d,%d,%d,%d]\",\"new_dims\":\"[%d,%d,%d,%d]\","
 	               "\"workspace\":%d,\"output\":\"%s\",\"output_id\":%d}",
@@ -612,7 +676,7 @@ resize_vertical(struct nedm_tile *tile, struct nedm_tile *parent, int y_offset,
 
 /* hpixs: positiv -> right, negative -> left; vpixs: positiv -> down, negative
  * -> up */
-void
+int
 resize_tile(struct nedm_server *server, int hpixs, int vpixs, int tile_id) {
 	struct nedm_output *output = server->curr_output;
 
@@ -622,7 +686,7 @@ resize_tile(struct nedm_server *server, int hpixs, int vpixs, int tile_id) {
 		tile = tile_from_id(server, tile_id);
 	}
 	if(tile == NULL) {
-		return;
+		return -1;
 	}
 	/* First do the horizontal adjustment */
 	if(hpixs != 0 && tile->tile.width < output_get_layout_box(output).width &&
@@ -655,9 +719,10 @@ resize_tile(struct nedm_server *server, int hpixs, int vpixs, int tile_id) {
 			resize_vertical(tile, NULL, y_offset, vpixs);
 		}
 	}
+	return 0;
 }
 
-void
+int
 keybinding_workspace_fullscreen(struct nedm_server *server, uint32_t screen,
                                 uint32_t workspace) {
 	struct nedm_output *output = server->curr_output;
@@ -667,15 +732,16 @@ keybinding_workspace_fullscreen(struct nedm_server *server, uint32_t screen,
 		ws = workspace;
 	}
 	if(output == NULL || ws >= server->nws) {
-		return;
+		return -1;
 	}
 	output_make_workspace_fullscreen(output, ws);
-	ipc_send_event(server,
+	ipc_send_event(server, NEDM_IPC_EVENT_FULLSCREEN,
 	               "{\"event_name\":\"fullscreen\",\"tile_id\":%d,"
 	               "\"workspace\":%d,\"output\":\"%s\",\"output_id\":%d}",
 	               output->workspaces[ws]->focused_tile->id,
 	               output->workspaces[ws]->num + 1, output->name,
 	               output_get_num(output));
+	return 0;
 }
 
 // Switch to a differerent virtual terminal
@@ -748,13 +814,14 @@ keybinding_split_output(struct nedm_output *output, bool vertical,
 	new_tile->tile.height = y + height - new_y;
 	new_tile->prev = curr_workspace->focused_tile;
 	new_tile->next = curr_workspace->focused_tile->next;
-	workspace_tile_update_view(new_tile, next_view);
 	new_tile->workspace = curr_workspace;
+	workspace_tile_update_view(new_tile, next_view);
 	curr_workspace->focused_tile->next->prev = new_tile;
 	curr_workspace->focused_tile->next = new_tile;
 
 	curr_workspace->focused_tile->tile.width = new_width;
 	curr_workspace->focused_tile->tile.height = new_height;
+	workspace_tiles_changed(curr_workspace);
 	workspace_focus_tile(curr_workspace, curr_workspace->focused_tile);
 
 	if(next_view != NULL) {
@@ -765,7 +832,7 @@ keybinding_split_output(struct nedm_output *output, bool vertical,
 		view_maximize(original_view, curr_workspace->focused_tile);
 	}
 	ipc_send_event(
-	    output->server,
+	    output->server, NEDM_IPC_EVENT_SPLIT,
 	    "{\"event_name\":\"split\",\"tile_id\":%d,\"new_tile_id\":%d,"
 	    "\"workspace\":%d,\"output\":\"%s\",\"output_id\":%d,\"vertical\":%d}",
 	    curr_workspace->focused_tile->id, new_tile->id, curr_workspace->num + 1,
@@ -785,7 +852,7 @@ keybinding_close_view(struct nedm_view *view) {
 	uint32_t ws = view->workspace->num;
 	view->impl->close(view);
 	ipc_send_event(
-	    outp->server,
+	    outp->server, NEDM_IPC_EVENT_CLOSE,
 	    "{\"event_name\":\"close\",\"view_id\":%d,\"view_pid\":%d,\"tile_id\":"
 	    "%d,\"workspace\":%d,\"output\":\"%s\",\"output_id\":%d}",
 	    view_id, view_pid, tile_id, ws + 1, outp->name, output_get_num(outp));
@@ -839,7 +906,7 @@ keybinding_cycle_outputs(struct nedm_server *server, bool reverse,
 	set_output(server, output);
 	if(trigger_event) {
 		ipc_send_event(
-		    output->server,
+		    output->server, NEDM_IPC_EVENT_CYCLE_OUTPUTS,
 		    "{\"event_name\":\"cycle_outputs\",\"old_output\":\"%s\",\"old_"
 		    "output_id\":%d,"
 		    "\"new_output\":\"%s\",\"new_output_id\":%d,\"reverse\":%d}",
@@ -849,7 +916,7 @@ keybinding_cycle_outputs(struct nedm_server *server, bool reverse,
 }
 
 /* Cycle through views, whereby the workspace does not change */
-void
+int
 keybinding_cycle_views(struct nedm_server *server, struct nedm_tile *tile,
                        uint32_t view_id, bool reverse, bool ipc) {
 	if(tile == NULL) {
@@ -879,13 +946,16 @@ keybinding_cycle_views(struct nedm_server *server, struct nedm_tile *tile,
 		}
 	} else {
 		next_view = view_from_id(server, view_id);
-		if(next_view == NULL || view_is_visible(next_view)) {
-			return;
+		if(next_view == NULL) {
+			return -1;
+		}
+		if(view_is_visible(next_view)) {
+			return 0;
 		}
 	}
 
 	if(next_view == NULL) {
-		return;
+		return 0;
 	}
 
 	workspace_tile_update_view(tile, next_view);
@@ -902,7 +972,7 @@ keybinding_cycle_views(struct nedm_server *server, struct nedm_tile *tile,
 			curr_pid = current_view->impl->get_pid(current_view);
 		}
 		ipc_send_event(
-		    ws->output->server,
+		    ws->output->server, NEDM_IPC_EVENT_CYCLE_VIEWS,
 		    "{\"event_name\":\"cycle_views\",\"old_view_id\":%d,\"old_view_"
 		    "pid\":%d,"
 		    "\"new_view_id\":%d,\"new_view_pid\":%d,\"tile_id\":%d,"
@@ -912,6 +982,7 @@ keybinding_cycle_views(struct nedm_server *server, struct nedm_tile *tile,
 		    next_view->tile->id, ws->num + 1, ws->output->name,
 		    output_get_num(ws->output));
 	}
+	return 0;
 }
 
 int
@@ -928,21 +999,22 @@ keybinding_switch_ws(struct nedm_server *server, uint32_t ws) {
 	seat_set_focus(server->seat,
 	               server->curr_output->workspaces[ws]->focused_tile->view);
 	message_printf(server->curr_output, "Workspace %d", ws + 1);
-	ipc_send_event(output->server,
-	               "{\"event_name\":\"switch_ws\",\"old_workspace\":%d,"
-	               "\"new_workspace\":%d,\"output\":\"%s\",\"output_id\":%d}",
-	               old_ws + 1, ws + 1, output->name, output_get_num(output));
+	ipc_send_state_event(
+	    output->server, NEDM_IPC_EVENT_SWITCH_WS, output->name,
+	    "{\"event_name\":\"switch_ws\",\"old_workspace\":%d,"
+	    "\"new_workspace\":%d,\"output\":\"%s\",\"output_id\":%d}",
+	    old_ws + 1, ws + 1, output->name, output_get_num(output));
 	return 0;
 }
 
-void
+int
 keybinding_focus_tile(struct nedm_server *server, uint32_t tile_id) {
 	struct nedm_output *output = server->curr_output;
 	struct nedm_workspace *workspace = output->workspaces[output->curr_workspace];
 	struct nedm_tile *old_tile = workspace->focused_tile;
 	struct nedm_tile *tile = tile_from_id(server, tile_id);
 	if(tile == NULL) {
-		return;
+		return -1;
 	}
 	if(server->curr_output != tile->workspace->output) {
 		set_output(server, tile->workspace->output);
@@ -953,14 +1025,16 @@ keybinding_focus_tile(struct nedm_server *server, uint32_t tile_id) {
 	workspace_focus_tile(tile->workspace, tile);
 	struct nedm_view *next_view = tile->workspace->focused_tile->view;
 	seat_set_focus(server->seat, next_view);
-	ipc_send_event(
-	    output->server,
+	ipc_send_state_event(
+	    output->server, NEDM_IPC_EVENT_FOCUS_TILE,
+	    tile->workspace->output->name,
 	    "{\"event_name\":\"focus_tile\",\"old_tile_id\":%d,\"new_tile_"
 	    "id\":%d,\"old_workspace\":%d,\"new_workspace\":%d,\"old_output\":\"%"
 	    "s\",\"old_output_id\":%d,\"output\":\"%s\",\"output_id\":%d}",
 	    old_tile->id, tile->workspace->focused_tile->id, workspace->num + 1,
 	    tile->workspace->num + 1, output->name, output_get_num(output),
 	    tile->workspace->output->name, output_get_num(tile->workspace->output));
+	return 0;
 }
 
 void
@@ -1251,11 +1325,88 @@ print_workspaces(struct nedm_output *outp) {
 }
 
 char *
-print_output(struct nedm_output *outp) {
+print_histogram(const struct nedm_histogram *hist) {
 	struct dyn_str outp_str;
 	outp_str.len = 0;
 	outp_str.cur_pos = 0;
-	uint32_t nmemb = 10;
+	uint32_t nmemb = NEDM_HISTOGRAM_SIZE + 2;
+	outp_str.str_arr = calloc(nmemb, sizeof(char *));
+	print_str(&outp_str,
+	          "{\"count\":%" PRIu64 ",\"avg_us\":%" PRIu64
+	          ",\"max_us\":%" PRIu64 ",\"buckets\":[",
+	          hist->count, hist->count == 0 ? 0 : hist->total_us / hist->count,
+	          hist->max_us);
+	for(uint32_t i = 0; i < NEDM_HISTOGRAM_SIZE; ++i) {
+		print_str(&outp_str, i == 0 ? "%" PRIu64 : ",%" PRIu64,
+		          hist->buckets[i]);
+	}
+	print_str(&outp_str, "]}");
+	return dyn_str_to_str(&outp_str);
+}
+
+char *
+print_composite_reasons(const struct nedm_frame_stats *stats) {
+	struct dyn_str str;
+	str.len = 0;
+	str.cur_pos = 0;
+	uint32_t nmemb = NEDM_COMPOSITE_REASON_COUNT;
+	str.str_arr = calloc(nmemb, sizeof(char *));
+	print_str(&str, "{");
+	for(int i = NEDM_COMPOSITE_NONE + 1; i < NEDM_COMPOSITE_REASON_COUNT;
+	    ++i) {
+		print_str(&str, "\"%s\":%" PRIu64 "%s",
+		          output_composite_reason_to_str(i),
+		          stats->composite_reasons[i],
+		          i + 1 < NEDM_COMPOSITE_REASON_COUNT ? "," : "}");
+	}
+	return dyn_str_to_str(&str);
+}
+
+char *
+print_ipc_events(struct nedm_server *server) {
+	struct dyn_str str;
+	str.len = 0;
+	str.cur_pos = 0;
+	uint32_t nmemb = NEDM_IPC_EVENT_COUNT + 1;
+	str.str_arr = calloc(nmemb, sizeof(char *));
+	print_str(&str, "\"ipc_events\":{");
+	for(int i = 0; i < NEDM_IPC_EVENT_COUNT; ++i) {
+		print_str(&str, "\"%s\":%" PRIu64 "%s", ipc_event_string[i],
+		          server->ipc.emitted[i],
+		          i + 1 < NEDM_IPC_EVENT_COUNT ? "," : "}");
+	}
+	return dyn_str_to_str(&str);
+}
+
+char *
+print_frame_stats(const struct nedm_frame_stats *stats) {
+	char *commit_str = print_histogram(&stats->commit_time);
+	char *interval_str = print_histogram(&stats->frame_interval);
+	char *reasons_str = print_composite_reasons(stats);
+	char *outp = NULL;
+	if(commit_str != NULL && interval_str != NULL && reasons_str != NULL) {
+		outp = malloc_vsprintf(
+		    "{\"commit_time\":%s,\"frame_interval\":%s,\"frames\":%" PRIu64
+		    ",\"skipped_commits\":%" PRIu64 ",\"missed_vblanks\":%" PRIu64
+		    ",\"delayed_frames\":%" PRIu64 ",\"scanout_frames\":%" PRIu64
+		    ",\"composited_frames\":%" PRIu64 ",\"composite_reasons\":%s}",
+		    commit_str, interval_str, stats->frames, stats->skipped_commits,
+		    stats->missed_vblanks, stats->delayed_frames,
+		    stats->scanout_frames, stats->composited_frames, reasons_str);
+	}
+	free(commit_str);
+	free(interval_str);
+	free(reasons_str);
+	return outp;
+}
+
+/* If full is false, workspaces and frame statistics are omitted */
+char *
+print_output(struct nedm_output *outp, bool full) {
+	struct dyn_str outp_str;
+	outp_str.len = 0;
+	outp_str.cur_pos = 0;
+	uint32_t nmemb = 14;
 	outp_str.str_arr = calloc(nmemb, sizeof(char *));
 	print_str(&outp_str, "\"%s\": {\n", outp->name);
 	print_str(&outp_str, "\"priority\": %d,\n", outp->priority);
@@ -1269,6 +1420,33 @@ print_output(struct nedm_output *outp) {
 	          outp->role == OUTPUT_ROLE_PERMANENT);
 	print_str(&outp_str, "\"active\": %d,\n", !outp->destroyed);
 	print_str(&outp_str, "\"curr_workspace\": %d,\n", outp->curr_workspace + 1);
+	if(outp->max_render_time == NEDM_MAX_RENDER_TIME_AUTO) {
+		print_str(&outp_str,
+		          "\"max_render_time\": \"auto\",\n"
+		          "\"render_budget_us\": %" PRId64 ",\n",
+		          output_render_budget_us(outp));
+	} else {
+		print_str(&outp_str,
+		          "\"max_render_time\": %d,\n\"render_budget_us\": %" PRId64
+		          ",\n",
+		          outp->max_render_time, output_render_budget_us(outp));
+	}
+	print_str(&outp_str,
+	          "\"adaptive_sync\": {\"mode\":\"%s\",\"enabled\":%d},\n",
+	          output_adaptive_sync_to_str(outp->adaptive_sync),
+	          outp->wlr_output->adaptive_sync_status ==
+	              WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED);
+	print_str(&outp_str, "\"composite_reason\": \"%s\",\n",
+	          output_composite_reason_to_str(outp->composite_reason));
+	if(!full) {
+		print_str(&outp_str, "\"nws\": %d\n}", outp->server->nws);
+		return dyn_str_to_str(&outp_str);
+	}
+	char *frame_stats_str = print_frame_stats(&outp->frame_stats);
+	if(frame_stats_str != NULL) {
+		print_str(&outp_str, "\"frame_stats\": %s,\n", frame_stats_str);
+		free(frame_stats_str);
+	}
 	char *workspaces_str = print_workspaces(outp);
 	if(workspaces_str != NULL) {
 		print_str(&outp_str, "%s", workspaces_str);
@@ -1279,7 +1457,7 @@ print_output(struct nedm_output *outp) {
 }
 
 char *
-print_outputs(struct nedm_server *server) {
+print_outputs(struct nedm_server *server, bool full) {
 	uint32_t noutps = wl_list_length(&server->outputs);
 	struct dyn_str outp_str;
 	outp_str.len = 0;
@@ -1293,7 +1471,7 @@ print_outputs(struct nedm_server *server) {
 			print_str(&outp_str, ",");
 		}
 		++count;
-		char *outp = print_output(it);
+		char *outp = print_output(it, full);
 		if(outp == NULL) {
 			continue;
 		}
@@ -1418,10 +1596,13 @@ get_mode_name(char **modes, unsigned int mode_nr) {
 
 void
 keybinding_dump(struct nedm_server *server) {
+	if(!ipc_event_subscribed(server, NEDM_IPC_EVENT_DUMP)) {
+		return;
+	}
 	struct dyn_str str;
 	str.len = 0;
 	str.cur_pos = 0;
-	uint32_t nmemb = 14;
+	uint32_t nmemb = 19;
 	str.str_arr = calloc(nmemb, sizeof(char *));
 
 	print_str(&str, "{\"event_name\":\"dump\",");
@@ -1447,7 +1628,7 @@ keybinding_dump(struct nedm_server *server) {
 		print_str(&str, "%s,", message_string);
 		free(message_string);
 	}
-	char *outps_str = print_outputs(server);
+	char *outps_str = print_outputs(server, true);
 	if(outps_str != NULL) {
 		print_str(&str, "%s,", outps_str);
 		free(outps_str);
@@ -1462,6 +1643,40 @@ keybinding_dump(struct nedm_server *server) {
 		print_str(&str, "%s,", input_dev_str);
 		free(input_dev_str);
 	}
+	print_str(&str,
+	          "\"cursor_motion\":{\"coalesce\":%d,\"events\":%" PRIu64
+	          ",\"processed\":%" PRIu64 ",\"saved\":%" PRIu64 "},\n",
+	          server->seat->coalesce_motion, server->seat->motion_events,
+	          server->seat->motion_processed,
+	          server->seat->motion_events > server->seat->motion_processed
+	              ? server->seat->motion_events - server->seat->motion_processed
+	              : 0);
+	print_str(&str,
+	          "\"hit_test_cache\":{\"hits\":%" PRIu64 ",\"misses\":%" PRIu64
+	          "},\n",
+	          server->seat->hit_cache_hits, server->seat->hit_cache_misses);
+	struct nedm_wallpaper_cache_stats wallpaper_stats;
+	nedm_wallpaper_cache_stats(server, &wallpaper_stats);
+	print_str(&str,
+	          "\"wallpaper_cache\":{\"images\":%u,\"renders\":%u,"
+	          "\"cpu_bytes\":%" PRIu64 ",\"gpu_bytes\":%" PRIu64 "},\n",
+	          wallpaper_stats.images, wallpaper_stats.renders,
+	          wallpaper_stats.cpu_bytes, wallpaper_stats.gpu_bytes);
+	struct nedm_message_cache *message_cache = &server->message_cache;
+	uint64_t message_lookups = message_cache->hits + message_cache->misses;
+	print_str(&str,
+	          "\"message_cache\":{\"entries\":%u,\"hits\":%" PRIu64
+	          ",\"misses\":%" PRIu64 ",\"hit_rate\":%f},\n",
+	          message_cache->nentries, message_cache->hits,
+	          message_cache->misses,
+	          message_lookups > 0
+	              ? (double)message_cache->hits / message_lookups
+	              : 0.0);
+	char *ipc_events_str = print_ipc_events(server);
+	if(ipc_events_str != NULL) {
+		print_str(&str, "%s,\n", ipc_events_str);
+		free(ipc_events_str);
+	}
 	print_str(&str, "\"cursor_coords\":{\"x\":%f,\"y\":%f}\n",
 	          server->seat->cursor->x, server->seat->cursor->y);
 	print_str(&str, "}");
@@ -1469,8 +1684,140 @@ keybinding_dump(struct nedm_server *server) {
 	char *send_str = dyn_str_to_str(&str);
 	if(send_str == NULL) {
 		wlr_log(WLR_ERROR, "Unable to create output string for \"dump\".");
+		return;
+	}
+	ipc_send_event(server, NEDM_IPC_EVENT_DUMP, "%s", send_str);
+	free(send_str);
+}
+
+/* Sends the part of the state selected by query to the client which ran the
+ * command. In contrast to "dump", only the requested subtree is serialized. */
+int
+keybinding_get(struct nedm_server *server, const uint32_t *query) {
+	struct nedm_ipc_client *client = server->ipc.current_client;
+	if(client == NULL) {
+		wlr_log(WLR_ERROR, "\"get\" can only be used over the socket");
+		return -1;
+	}
+	char *outp = NULL;
+	switch(query[0]) {
+	case NEDM_QUERY_OUTPUTS: {
+		char *outps_str = print_outputs(server, false);
+		if(outps_str != NULL) {
+			outp = malloc_vsprintf("{\"event_name\":\"get\",\"query\":"
+			                       "\"outputs\",%s}",
+			                       outps_str);
+			free(outps_str);
+		}
+		break;
+	}
+	case NEDM_QUERY_WORKSPACE: {
+		struct nedm_output *output = output_from_num(server, query[1]);
+		if(output == NULL || query[2] > (uint32_t)server->nws) {
+			wlr_log(WLR_ERROR, "Workspace %u of output %u does not exist",
+			        query[2], query[1]);
+			return -1;
+		}
+		char *ws_str = print_workspace(output->workspaces[query[2] - 1]);
+		if(ws_str != NULL) {
+			outp = malloc_vsprintf(
+			    "{\"event_name\":\"get\",\"query\":\"workspace\","
+			    "\"output\":\"%s\",\"output_id\":%d,\"workspace\":%u,"
+			    "\"current\":%d,%s}",
+			    output->name, output_get_num(output), query[2],
+			    output->curr_workspace + 1 == (int)query[2], ws_str);
+			free(ws_str);
+		}
+		break;
+	}
+	case NEDM_QUERY_VIEW: {
+		struct nedm_view *view = view_from_id(server, query[1]);
+		if(view == NULL) {
+			wlr_log(WLR_ERROR, "View %u does not exist", query[1]);
+			return -1;
+		}
+		char *view_str = print_view(view);
+		if(view_str != NULL) {
+			outp = malloc_vsprintf(
+			    "{\"event_name\":\"get\",\"query\":\"view\","
+			    "\"output\":\"%s\",\"output_id\":%d,\"workspace\":%d,"
+			    "\"tile_id\":%d,\"view\":{%s}}",
+			    view->workspace->output->name,
+			    output_get_num(view->workspace->output),
+			    view->workspace->num + 1,
+			    view->tile == NULL ? -1 : (int)view->tile->id, view_str);
+			free(view_str);
+		}
+		break;
+	}
+	case NEDM_QUERY_FOCUSED: {
+		struct nedm_output *output = server->curr_output;
+		struct nedm_workspace *ws = output->workspaces[output->curr_workspace];
+		struct nedm_view *view = seat_get_focus(server->seat);
+		outp = malloc_vsprintf(
+		    "{\"event_name\":\"get\",\"query\":\"focused\",\"output\":\"%s\","
+		    "\"output_id\":%d,\"workspace\":%d,\"tile_id\":%d,"
+		    "\"view_id\":%d}",
+		    output->name, output_get_num(output), ws->num + 1,
+		    ws->focused_tile->id, view == NULL ? -1 : (int)view->id);
+		break;
+	}
+	default:
+		return -1;
+	}
+	if(outp == NULL) {
+		wlr_log(WLR_ERROR, "Unable to create output string for \"get\".");
+		return -1;
+	}
+	ipc_send_reply(client, NEDM_IPC_EVENT_GET, "%s", outp);
+	free(outp);
+	return 0;
+}
+
+void
+keybinding_frame_stats(struct nedm_server *server, bool reset) {
+	if(!ipc_event_subscribed(server, NEDM_IPC_EVENT_FRAME_STATS)) {
+		if(reset) {
+			struct nedm_output *output;
+			wl_list_for_each(output, &server->outputs, link) {
+				output_frame_stats_reset(output);
+			}
+		}
+		return;
+	}
+	uint32_t noutps = wl_list_length(&server->outputs);
+	struct dyn_str str;
+	str.len = 0;
+	str.cur_pos = 0;
+	str.str_arr = calloc(2 * noutps + 2, sizeof(char *));
+
+	print_str(&str,
+	          "{\"event_name\":\"frame_stats\",\"reset\":%d,\"outputs\":{",
+	          reset);
+	struct nedm_output *it;
+	uint32_t count = 0;
+	wl_list_for_each(it, &server->outputs, link) {
+		char *stats_str = print_frame_stats(&it->frame_stats);
+		if(reset) {
+			output_frame_stats_reset(it);
+		}
+		if(stats_str == NULL) {
+			continue;
+		}
+		print_str(&str, count == 0 ? "\"%s\":%s" : ",\"%s\":%s", it->name,
+		          stats_str);
+		free(stats_str);
+		++count;
+	}
+	print_str(&str, "}}");
+
+	char *send_str = dyn_str_to_str(&str);
+	if(send_str == NULL) {
+		wlr_log(WLR_ERROR,
+		        "Unable to create output string for \"frame_stats\".");
+		return;
 	}
-	ipc_send_event(server, send_str);
+	ipc_send_event(server, NEDM_IPC_EVENT_FRAME_STATS, "%s", send_str);
 	free(send_str);
 }
 
@@ -1493,7 +1840,7 @@ keybinding_display_message(struct nedm_server *server, char *msg) {
 
 void
 keybinding_send_custom_event(struct nedm_server *server, char *msg) {
-	ipc_send_event(server,
+	ipc_send_event(server, NEDM_IPC_EVENT_CUSTOM_EVENT,
 	               "{\"event_name\":\"custom_event\",\"message\":\"%s\"}", msg);
 }
 
@@ -1534,7 +1881,7 @@ keybinding_move_view_to_cycle_output(struct nedm_server *server, bool reverse) {
 		pid = view->impl->get_pid(view);
 	}
 	ipc_send_event(
-	    server,
+	    server, NEDM_IPC_EVENT_MOVE_VIEW_TO_CYCLE_OUTPUT,
 	    "{\"event_name\":\"move_view_to_cycle_output\",\"view_id\":%d,\"view_"
 	    "pid\":%d,\"old_output\":\"%s\",\"old_output_id\":%d,\"new_output\":\"%"
 	    "s\",\"new_output_id\":%d,\"old_tile_id\":%d,\"new_tile_id\":%d}",
@@ -1597,7 +1944,7 @@ keybinding_set_nws(struct nedm_server *server, int nws) {
 	    server->seat,
 	    server->curr_output->workspaces[server->curr_output->curr_workspace]
 	        ->focused_tile->view);
-	ipc_send_event(server,
+	ipc_send_event(server, NEDM_IPC_EVENT_SET_NWS,
 	               "{\"event_name\":\"set_nws\",\"old_nws\":%d,\"new_nws\":%d}",
 	               old_nws, server->nws);
 }
@@ -1625,14 +1972,14 @@ keybinding_definemode(struct nedm_server *server, char *mode) {
 	server->modecursors[length] = NULL;
 
 	server->modes[length - 1] = strdup(mode);
-	ipc_send_event(server, "{\"event_name\":\"definemode\",\"mode\":\"%s\"}",
-	               mode);
+	ipc_send_event(server, NEDM_IPC_EVENT_DEFINEMODE,
+	               "{\"event_name\":\"definemode\",\"mode\":\"%s\"}", mode);
 }
 
 void
 keybinding_definekey(struct nedm_server *server, struct keybinding *kb) {
 	keybinding_list_push(server->keybindings, kb);
-	ipc_send_event(server,
+	ipc_send_event(server, NEDM_IPC_EVENT_DEFINEKEY,
 	               "{\"event_name\":\"definekey\",\"modifiers\":%d,\"key\":"
 	               "%d,\"command\":\"%s\"}",
 	               kb->modifiers, kb->key,
@@ -1641,7 +1988,7 @@ keybinding_definekey(struct nedm_server *server, struct keybinding *kb) {
 
 void
 keybinding_set_background(struct nedm_server *server, float *bg) {
-	ipc_send_event(server,
+	ipc_send_event(server, NEDM_IPC_EVENT_BACKGROUND,
 	               "{\"event_name\":\"background\",\"old_bg\":[%f,%f,%f],"
 	               "\"new_bg\":[%f,%f,%f]}",
 	               server->bg_color[0], server->bg_color[1],
@@ -1658,25 +2005,25 @@ keybinding_set_background(struct nedm_server *server, float *bg) {
 	}
 }
 
-void
+int
 keybinding_switch_output(struct nedm_server *server, int output) {
 	struct nedm_output *old_outp = server->curr_output;
 	struct nedm_output *new_outp = output_from_num(server, output);
 	if(new_outp != NULL) {
 		set_output(server, new_outp);
-		ipc_send_event(server,
+		ipc_send_event(server, NEDM_IPC_EVENT_SWITCH_OUTPUT,
 		               "{\"event_name\":\"switch_output\",\"old_output\":"
 		               "\"%s\",\"old_output_id\":%d,\"new_output\":\"%s\","
 		               "\"new_output_id\":%d}",
 		               old_outp->name, output_get_num(old_outp), new_outp->name,
 		               output_get_num(new_outp));
-		return;
+		return 0;
 	}
 	message_printf(server->curr_output, "Output %d does not exist", output);
-	return;
+	return -1;
 }
 
-void
+int
 keybinding_move_view_to_tile(struct nedm_server *server, uint32_t view_id,
                              uint32_t tile_id, bool follow) {
 	struct nedm_view *view = view_from_id(server, view_id);
@@ -1685,7 +2032,7 @@ keybinding_move_view_to_tile(struct nedm_server *server, uint32_t view_id,
 	struct nedm_output *old_outp = view ? view->workspace->output : NULL;
 	int old_workspace = view ? (int)view->workspace->num : -1;
 	if(tile == NULL) {
-		return;
+		return -1;
 	}
 	if(view != NULL) {
 		if(old_tile != NULL) {
@@ -1729,30 +2076,31 @@ keybinding_move_view_to_tile(struct nedm_server *server, uint32_t view_id,
 		}
 	}
 	ipc_send_event(
-	    server,
+	    server, NEDM_IPC_EVENT_MOVE_VIEW,
 	    "{\"event_name\":\"move_view\",\"view_id\":%d,\"old_output\":\"%s\","
 	    "\"old_workspace\":\"%d\",\"old_tile\":\"%d\",\"new_output\":\"%s\","
 	    "\"new_workspace\":\"%d\",\"new_tile\":\"%d\"}",
 	    view_id, old_outp ? old_outp->name : "", old_workspace,
 	    old_tile ? (int)old_tile->id : -1, server->curr_output->name,
 	    tile->workspace->num, tile->id);
+	return 0;
 }
 
-void
+int
 keybinding_move_view_to_output(struct nedm_server *server, int view_id,
                                int output_num, bool follow) {
 	struct nedm_output *outp = output_from_num(server, output_num);
-	if(outp != NULL) {
-		keybinding_move_view_to_tile(
-		    server, view_id,
-		    outp->workspaces[outp->curr_workspace]->focused_tile->id, follow);
-	} else {
+	if(outp == NULL) {
 		message_printf(server->curr_output, "Output number %d not found.",
 		               output_num);
+		return -1;
 	}
+	return keybinding_move_view_to_tile(
+	    server, view_id,
+	    outp->workspaces[outp->curr_workspace]->focused_tile->id, follow);
 }
 
-void
+int
 keybinding_move_view_to_workspace(struct nedm_server *server, int view_id,
                                   uint32_t ws, bool follow) {
 	if(ws >= server->nws) {
@@ -1760,9 +2108,9 @@ keybinding_move_view_to_workspace(struct nedm_server *server, int view_id,
 		               "Attempting to move view to workspace %d, but there are "
 		               "only %d workspaces.",
 		               ws + 1, server->nws);
-		return;
+		return -1;
 	}
-	keybinding_move_view_to_tile(
+	return keybinding_move_view_to_tile(
 	    server, view_id, server->curr_output->workspaces[ws]->focused_tile->id,
 	    follow);
 }
@@ -1782,6 +2130,12 @@ merge_config(struct nedm_output_config *config_new,
 	if(config_new->priority == -1) {
 		config_new->priority = config_old->priority;
 	}
+	if(config_new->max_render_time == -1) {
+		config_new->max_render_time = config_old->max_render_time;
+	}
+	if(config_new->adaptive_sync == -1) {
+		config_new->adaptive_sync = config_old->adaptive_sync;
+	}
 }
 
 void
@@ -1814,7 +2168,7 @@ keybinding_configure_output(struct nedm_server *server,
 		if(strcmp(config->output_name, output->name) == 0) {
 			int output_num = output_get_num(output);
 			output_configure(server, output);
-			ipc_send_event(server,
+			ipc_send_event(server, NEDM_IPC_EVENT_CONFIGURE_OUTPUT,
 			               "{\"event_name\":\"configure_output\",\"output\":\"%"
 			               "s\",\"output_id\":%d}",
 			               cfg->output_name, output_num);
@@ -1825,7 +2179,7 @@ keybinding_configure_output(struct nedm_server *server,
 		if(strcmp(config->output_name, output->name) == 0) {
 			output_configure(server, output);
 			ipc_send_event(
-			    output->server,
+			    output->server, NEDM_IPC_EVENT_CONFIGURE_OUTPUT,
 			    "{\"event_name\":\"configure_output\",\"output\":\"%s\"}",
 			    cfg->output_name);
 			return;
@@ -1851,7 +2205,7 @@ keybinding_configure_input(struct nedm_server *server,
 	}
 	wl_list_insert(&server->input_config, &ocfg->link);
 	nedm_input_manager_configure(server);
-	ipc_send_event(server,
+	ipc_send_event(server, NEDM_IPC_EVENT_CONFIGURE_INPUT,
 	               "{\"event_name\":\"configure_input\",\"input\":\"%s\"}",
 	               cfg->identifier);
 }
@@ -1884,7 +2238,49 @@ keybinding_configure_message(struct nedm_server *server,
 	if(config->enabled != -1) {
 		server->message_config.enabled = config->enabled;
 	}
-	ipc_send_event(server, "{\"event_name\":\"configure_message\"}");
+	ipc_send_event(server, NEDM_IPC_EVENT_CONFIGURE_MESSAGE,
+	               "{\"event_name\":\"configure_message\"}");
+}
+
+void
+keybinding_configure_wallpaper(struct nedm_server *server,
+                               struct nedm_wallpaper_config *config) {
+	if(config->image_path != NULL) {
+		free(server->wallpaper_config.image_path);
+		server->wallpaper_config.image_path = strdup(config->image_path);
+	}
+	if(config->mode != NEDM_WALLPAPER_NOPT) {
+		server->wallpaper_config.mode = config->mode;
+	}
+	if(config->bg_color[0] != -1) {
+		server->wallpaper_config.bg_color[0] = config->bg_color[0];
+		server->wallpaper_config.bg_color[1] = config->bg_color[1];
+		server->wallpaper_config.bg_color[2] = config->bg_color[2];
+		server->wallpaper_config.bg_color[3] = config->bg_color[3];
+	}
+	if(config->transition_time != -1) {
+		server->wallpaper_config.transition_time = config->transition_time;
+	}
+	if(config->slideshow != NULL || config->slideshow_interval != -1) {
+		if(config->slideshow != NULL) {
+			free(server->wallpaper_config.slideshow);
+			server->wallpaper_config.slideshow = strdup(config->slideshow);
+		}
+		if(config->slideshow_interval != -1) {
+			server->wallpaper_config.slideshow_interval =
+			    config->slideshow_interval;
+		}
+		/* Restarts the slideshow with its first image */
+		nedm_wallpaper_slideshow_configure(server);
+	}
+	/* Images are decoded on the worker, the current wallpaper stays visible
+	 * until the new one is ready */
+	struct nedm_wallpaper *wallpaper;
+	wl_list_for_each(wallpaper, &server->wallpapers, link) {
+		nedm_wallpaper_configure(wallpaper);
+	}
+	ipc_send_event(server, NEDM_IPC_EVENT_CONFIGURE_WALLPAPER,
+	               "{\"event_name\":\"configure_wallpaper\"}");
 }
 
 void
@@ -1913,9 +2309,11 @@ run_action(enum keybinding_action action, struct nedm_server *server,
 	case KEYBINDING_CURSOR:
 		set_cursor(data.i, server->seat);
 		break;
-	case KEYBINDING_LAYOUT_FULLSCREEN:
-		keybinding_workspace_fullscreen(server, data.us[0], data.us[1]);
+	case KEYBINDING_CURSOR_COALESCE:
+		seat_set_coalesce_motion(server->seat, data.b);
 		break;
+	case KEYBINDING_LAYOUT_FULLSCREEN:
+		return keybinding_workspace_fullscreen(server, data.us[0], data.us[1]);
 	case KEYBINDING_SPLIT_HORIZONTAL:
 		keybinding_split_horizontal(server, data.f);
 		break;
@@ -1938,24 +2336,22 @@ run_action(enum keybinding_action action, struct nedm_server *server,
 		}
 	} break;
 	case KEYBINDING_CYCLE_VIEWS:
-		keybinding_cycle_views(server, NULL, data.us[1], data.us[0], true);
-		break;
+		return keybinding_cycle_views(server, NULL, data.us[1], data.us[0],
+		                              true);
 	case KEYBINDING_CYCLE_TILES:
 		if(data.us[1] == 0) {
 			keybinding_cycle_tiles(server, data.us[0]);
 		} else {
-			keybinding_focus_tile(server, data.us[1]);
+			return keybinding_focus_tile(server, data.us[1]);
 		}
 		break;
 	case KEYBINDING_CYCLE_OUTPUT:
 		keybinding_cycle_outputs(server, data.b, true);
 		break;
 	case KEYBINDING_SWITCH_WORKSPACE:
-		keybinding_switch_ws(server, data.u);
-		break;
+		return keybinding_switch_ws(server, data.u);
 	case KEYBINDING_SWITCH_OUTPUT:
-		keybinding_switch_output(server, data.u);
-		break;
+		return keybinding_switch_output(server, data.u);
 	case KEYBINDING_SWITCH_MODE:
 		uint32_t n_modes = 0;
 		while(server->modes[n_modes] != NULL) {
@@ -1974,7 +2370,7 @@ run_action(enum keybinding_action action, struct nedm_server *server,
 		server->seat->mode = data.u;
 		break;
 	case KEYBINDING_SWITCH_DEFAULT_MODE:
-		ipc_send_event(server,
+		ipc_send_event(server, NEDM_IPC_EVENT_SWITCH_DEFAULT_MODE,
 		               "{\"event_name\":\"switch_default_mode\",\"old_mode\":"
 		               "\"%s\",\"mode\":\"%s\"}",
 		               get_mode_name(server->modes, server->seat->default_mode),
@@ -2006,9 +2402,18 @@ run_action(enum keybinding_action action, struct nedm_server *server,
 	case KEYBINDING_SHOW_TIME:
 		keybinding_show_time(server);
 		break;
+	case KEYBINDING_FRAME_STATS:
+		keybinding_frame_stats(server, data.b);
+		break;
 	case KEYBINDING_DUMP:
 		keybinding_dump(server);
 		break;
+	case KEYBINDING_SUBSCRIBE:
+		return ipc_subscribe(server, data.mask);
+	case KEYBINDING_IPC_POLICY:
+		return ipc_set_policy(server, data.u);
+	case KEYBINDING_GET:
+		return keybinding_get(server, data.us);
 	case KEYBINDING_SHOW_INFO:
 		keybinding_show_info(server);
 		break;
@@ -2019,49 +2424,41 @@ run_action(enum keybinding_action action, struct nedm_server *server,
 		keybinding_send_custom_event(server, data.c);
 		break;
 	case KEYBINDING_RESIZE_TILE_HORIZONTAL:
-		resize_tile(server, data.is[0], 0, data.is[1]);
-		break;
+		return resize_tile(server, data.is[0], 0, data.is[1]);
 	case KEYBINDING_RESIZE_TILE_VERTICAL:
-		resize_tile(server, 0, data.is[0], data.is[1]);
-		break;
+		return resize_tile(server, 0, data.is[0], data.is[1]);
 	case KEYBINDING_MOVE_TO_TILE: {
 		struct nedm_view *view =
 		    server->curr_output->workspaces[server->curr_output->curr_workspace]
 		        ->focused_tile->view;
-		keybinding_move_view_to_tile(server, view ? (int)view->id : -1,
-		                             data.us[0], data.us[1] > 0);
-		break;
+		return keybinding_move_view_to_tile(server, view ? (int)view->id : -1,
+		                                    data.us[0], data.us[1] > 0);
 	}
 	case KEYBINDING_MOVE_TO_WORKSPACE: {
 		struct nedm_view *view =
 		    server->curr_output->workspaces[server->curr_output->curr_workspace]
 		        ->focused_tile->view;
-		keybinding_move_view_to_workspace(server, view ? (int)view->id : -1,
-		                                  data.us[0], data.us[1] > 0);
-		break;
+		return keybinding_move_view_to_workspace(
+		    server, view ? (int)view->id : -1, data.us[0], data.us[1] > 0);
 	}
 	case KEYBINDING_MOVE_TO_OUTPUT: {
 		struct nedm_view *view =
 		    server->curr_output->workspaces[server->curr_output->curr_workspace]
 		        ->focused_tile->view;
-		keybinding_move_view_to_output(server, view ? (int)view->id : -1,
-		                               data.us[0], data.us[1] > 0);
-		break;
+		return keybinding_move_view_to_output(
+		    server, view ? (int)view->id : -1, data.us[0], data.us[1] > 0);
 	}
 	case KEYBINDING_MOVE_VIEW_TO_TILE: {
-		keybinding_move_view_to_tile(server, data.us[0], data.us[1],
-		                             data.us[2] > 0);
-		break;
+		return keybinding_move_view_to_tile(server, data.us[0], data.us[1],
+		                                    data.us[2] > 0);
 	}
 	case KEYBINDING_MOVE_VIEW_TO_WORKSPACE: {
-		keybinding_move_view_to_workspace(server, data.us[0], data.us[1],
-		                                  data.us[2] > 0);
-		break;
+		return keybinding_move_view_to_workspace(server, data.us[0],
+		                                         data.us[1], data.us[2] > 0);
 	}
 	case KEYBINDING_MOVE_VIEW_TO_OUTPUT: {
-		keybinding_move_view_to_output(server, data.us[0], data.us[1],
-		                               data.us[2] > 0);
-		break;
+		return keybinding_move_view_to_output(server, data.us[0], data.us[1],
+		                                      data.us[2] > 0);
 	}
 	case KEYBINDING_MERGE_LEFT: {
 		struct nedm_tile *tile =
@@ -2070,9 +2467,10 @@ run_action(enum keybinding_action action, struct nedm_server *server,
 		if(data.u != 0) {
 			tile = tile_from_id(server, data.u);
 		}
-		if(tile != NULL) {
-			merge_tile_left(tile);
+		if(tile == NULL) {
+			return -1;
 		}
+		merge_tile_left(tile);
 		break;
 	}
 	case KEYBINDING_MERGE_RIGHT: {
@@ -2082,9 +2480,10 @@ run_action(enum keybinding_action action, struct nedm_server *server,
 		if(data.u != 0) {
 			tile = tile_from_id(server, data.u);
 		}
-		if(tile != NULL) {
-			merge_tile_right(tile);
+		if(tile == NULL) {
+			return -1;
 		}
+		merge_tile_right(tile);
 		break;
 	}
 	case KEYBINDING_MERGE_TOP: {
@@ -2094,9 +2493,10 @@ run_action(enum keybinding_action action, struct nedm_server *server,
 		if(data.u != 0) {
 			tile = tile_from_id(server, data.u);
 		}
-		if(tile != NULL) {
-			merge_tile_top(tile);
+		if(tile == NULL) {
+			return -1;
 		}
+		merge_tile_top(tile);
 		break;
 	}
 	case KEYBINDING_MERGE_BOTTOM: {
@@ -2106,30 +2506,31 @@ run_action(enum keybinding_action action, struct nedm_server *server,
 		if(data.u != 0) {
 			tile = tile_from_id(server, data.u);
 		}
-		if(tile != NULL) {
-			merge_tile_bottom(tile);
+		if(tile == NULL) {
+			return -1;
 		}
+		merge_tile_bottom(tile);
 		break;
 	}
 	case KEYBINDING_SWAP_LEFT: {
-		swap_tile_left(server, data.us[0], data.us[1] == 1);
-		break;
+		return swap_tile_left(server, data.us[0], data.us[1] == 1);
 	}
 	case KEYBINDING_SWAP_RIGHT: {
-		swap_tile_right(server, data.us[0], data.us[1] == 1);
-		break;
+		return swap_tile_right(server, data.us[0], data.us[1] == 1);
 	}
 	case KEYBINDING_SWAP_TOP: {
-		swap_tile_top(server, data.us[0], data.us[1] == 1);
-		break;
+		return swap_tile_top(server, data.us[0], data.us[1] == 1);
 	}
 	case KEYBINDING_SWAP_BOTTOM: {
-		swap_tile_bottom(server, data.us[0], data.us[1] == 1);
-		break;
+		return swap_tile_bottom(server, data.us[0], data.us[1] == 1);
 	}
 	case KEYBINDING_SWAP: {
-		swap_tiles(tile_from_id(server, data.us[0]),
-		           tile_from_id(server, data.us[1]), data.us[2] == 1);
+		struct nedm_tile *tile = tile_from_id(server, data.us[0]);
+		struct nedm_tile *swap = tile_from_id(server, data.us[1]);
+		if(tile == NULL || swap == NULL) {
+			return -1;
+		}
+		swap_tiles(tile, swap, data.us[2] == 1);
 		break;
 	}
 	case KEYBINDING_FOCUS_LEFT: {
@@ -2178,6 +2579,9 @@ run_action(enum keybinding_action action, struct nedm_server *server,
 	case KEYBINDING_CONFIGURE_MESSAGE:
 		keybinding_configure_message(server, data.m_cfg);
 		break;
+	case KEYBINDING_CONFIGURE_WALLPAPER:
+		keybinding_configure_wallpaper(server, data.wp_cfg);
+		break;
 	case KEYBINDING_CONFIGURE_INPUT:
 		keybinding_configure_input(server, data.i_cfg);
 		break;
@@ -79,11 +79,15 @@ struct nedm_server;
 	           move_view_to_cycle_output) /* data.b is 0 if forward, 1 if */   \
                                                                                \
 	KEYBINDING(KEYBINDING_DUMP, dump)                                          \
+	KEYBINDING(KEYBINDING_FRAME_STATS,                                         \
+	           frame_stats) /* data.b is whether to reset the statistics */    \
 	KEYBINDING(KEYBINDING_SHOW_TIME, time)                                     \
 	KEYBINDING(KEYBINDING_SHOW_INFO, show_info)                                \
 	KEYBINDING(KEYBINDING_DISPLAY_MESSAGE, message)                            \
 	KEYBINDING(KEYBINDING_SEND_CUSTOM_EVENT, custom_event)                     \
 	KEYBINDING(KEYBINDING_CURSOR, cursor)                                      \
+	KEYBINDING(KEYBINDING_CURSOR_COALESCE,                                     \
+	           cursor_coalesce) /* data.b is whether to coalesce motion */     \
                                                                                \
 	KEYBINDING(KEYBINDING_SWAP_LEFT, exchangeleft)                             \
 	KEYBINDING(KEYBINDING_SWAP_RIGHT, exchangeright)                           \
@@ -114,7 +118,13 @@ struct nedm_server;
 	KEYBINDING(KEYBINDING_DEFINEMODE,                                          \
 	           definemode) /* data.c is the mode name */                       \
 	KEYBINDING(KEYBINDING_WORKSPACES,                                          \
-	           workspaces) /* data.i is the number of workspaces */
+	           workspaces) /* data.i is the number of workspaces */            \
+	KEYBINDING(KEYBINDING_SUBSCRIBE,                                           \
+	           subscribe) /* data.mask is the bitmask of events to send */     \
+	KEYBINDING(KEYBINDING_IPC_POLICY,                                          \
+	           ipc_policy) /* data.u is the policy for slow clients */         \
+	KEYBINDING(KEYBINDING_GET,                                                 \
+	           get) /* data.us is the kind of query and its arguments */
 
 #define GENERATE_ENUM(ENUM, NAME) ENUM,
 #define GENERATE_STRING(STRING, NAME) #NAME,
@@ -126,6 +136,14 @@ enum keybinding_action { FOREACH_KEYBINDING(GENERATE_ENUM) };
 
 extern char *keybinding_action_string[];
 
+/* Parts of the state which can be queried with the "get" command */
+enum nedm_query {
+	NEDM_QUERY_OUTPUTS,
+	NEDM_QUERY_WORKSPACE, // Arguments are the output id and workspace number
+	NEDM_QUERY_VIEW,      // Argument is the view id
+	NEDM_QUERY_FOCUSED,
+};
+
 union keybinding_params {
 	char *c;
 	char *cs[2];
@@ -136,6 +154,7 @@ union keybinding_params {
 	bool b;
 	float f;
 	float color[3];
+	uint64_t mask;
 	struct keybinding *kb;
 	struct nedm_output_config *o_cfg;
 	struct nedm_input_config *i_cfg;
@@ -151,10 +170,23 @@ struct keybinding {
 	union keybinding_params data; // See enum keybinding_action for details
 };
 
+/* Open addressing hash table mapping (modifiers, key) to the position of the
+ * corresponding keybinding in keybinding_list->keybindings. Slots hold the
+ * position plus one, zero denotes an empty slot. Since keybindings are only
+ * ever replaced in place, no tombstones are required. */
+struct keybinding_index {
+	uint32_t length;
+	uint32_t capacity; // Always a power of two (or zero)
+	uint32_t *slots;
+};
+
 struct keybinding_list {
 	uint32_t length;
 	uint32_t capacity;
 	struct keybinding **keybindings;
+	/* One index per mode, indexed by keybinding->mode */
+	uint32_t nindices;
+	struct keybinding_index *indices;
 };
 
 int
@@ -346,6 +346,7 @@ void nedm_arrange_layers(struct nedm_output *output) {
 	if (!output || !output->wlr_output) {
 		return;
 	}
+	++output->server->scene_generation;
 	
 	wlr_log(WLR_ERROR, "NEDM ARRANGE LAYERS: Called for output %s (%dx%d)",
 		output->wlr_output->name, output->wlr_output->width, output->wlr_output->height);
@@ -4,8 +4,8 @@
 #include <cairo/cairo.h>
 #include <drm_fourcc.h>
 #include <pango/pangocairo.h>
+#include <string.h>
 #include <sys/mman.h>
-#include <unistd.h>
 #include <wayland-client.h>
 #include <wlr/backend.h>
 #include <wlr/interfaces/wlr_buffer.h>
@@ -27,12 +27,58 @@ struct msg_buffer {
 	void *data;
 	uint32_t format;
 	size_t stride;
+	struct nedm_message_pool *pool;
+	int size_class; // -1 if the data is not taken from the pool
 };
 
+struct message_cache_entry {
+	char *text;
+	char *font;
+	double scale;
+	enum wl_output_subpixel subpixel;
+	float bg_color[4];
+	float fg_color[4];
+	struct msg_buffer *buf; // Locked by the cache
+	struct wl_list link;    // nedm_message_cache::entries
+};
+
+static int
+msg_pool_size_class(size_t size) {
+	size_t class_size = NEDM_MESSAGE_POOL_MIN_SIZE;
+	for(int i = 0; i < NEDM_MESSAGE_POOL_CLASSES; ++i) {
+		if(size <= class_size) {
+			return i;
+		}
+		class_size <<= 1;
+	}
+	return -1;
+}
+
+static void *
+msg_pool_get(struct nedm_message_pool *pool, int size_class, size_t size) {
+	if(size_class < 0) {
+		return malloc(size);
+	}
+	if(pool->nfree[size_class] > 0) {
+		return pool->data[size_class][--pool->nfree[size_class]];
+	}
+	return malloc((size_t)NEDM_MESSAGE_POOL_MIN_SIZE << size_class);
+}
+
+static void
+msg_pool_put(struct nedm_message_pool *pool, int size_class, void *data) {
+	if(size_class < 0 || pool->finished ||
+	   pool->nfree[size_class] == NEDM_MESSAGE_POOL_DEPTH) {
+		free(data);
+		return;
+	}
+	pool->data[size_class][pool->nfree[size_class]++] = data;
+}
+
 static void
 msg_buffer_destroy(struct wlr_buffer *wlr_buffer) {
 	struct msg_buffer *buffer = wl_container_of(wlr_buffer, buffer, base);
-	free(buffer->data);
+	msg_pool_put(buffer->pool, buffer->size_class, buffer->data);
 	free(buffer);
 }
 
@@ -67,24 +113,29 @@ static const struct wlr_buffer_impl msg_buffer_impl = {
 };
 
 static struct msg_buffer *
-msg_buffer_create(uint32_t width, uint32_t height, uint32_t stride) {
+msg_buffer_create(struct nedm_message_pool *pool, uint32_t width,
+                  uint32_t height, uint32_t stride) {
 	struct msg_buffer *buffer = calloc(1, sizeof(*buffer));
 	if(buffer == NULL) {
 		return NULL;
 	}
 
-	wlr_buffer_init(&buffer->base, &msg_buffer_impl, width, height);
-	buffer->format = DRM_FORMAT_ARGB8888;
-	buffer->stride = stride;
-
-	buffer->data = malloc(buffer->stride * height);
+	buffer->pool = pool;
+	buffer->size_class = msg_pool_size_class((size_t)stride * height);
+	buffer->data =
+	    msg_pool_get(pool, buffer->size_class, (size_t)stride * height);
 	if(buffer->data == NULL) {
 		free(buffer);
 		return NULL;
 	}
 
+	wlr_buffer_init(&buffer->base, &msg_buffer_impl, width, height);
+	buffer->format = DRM_FORMAT_ARGB8888;
+	buffer->stride = stride;
+
 	return buffer;
 }
+
 cairo_subpixel_order_t
 to_cairo_subpixel_order(const enum wl_output_subpixel subpixel) {
 	switch(subpixel) {
@@ -102,6 +153,13 @@ to_cairo_subpixel_order(const enum wl_output_subpixel subpixel) {
 	return CAIRO_SUBPIXEL_ORDER_DEFAULT;
 }
 
+/* The font is not set if the configuration was never loaded, as when
+ * fuzzing */
+static const char *
+message_font(const struct nedm_message_config *config) {
+	return config->font != NULL ? config->font : NEDM_MESSAGE_DEFAULT_FONT;
+}
+
 struct msg_buffer *
 create_message_texture(const char *string, const struct nedm_output *output) {
 	const int WIDTH_PADDING = 8;
@@ -111,40 +169,47 @@ create_message_texture(const char *string, const struct nedm_output *output) {
 	int width = 0;
 	int height = 0;
 
-	// We must use a non-nil cairo_t for cairo_set_font_options to work.
-	// Therefore, we cannot use cairo_create(NULL).
-	cairo_surface_t *dummy_surface =
-	    cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 0, 0);
-	// This occurs when we are fuzzing. In that case, do nothing
-	if(dummy_surface == NULL) {
-		return NULL;
-	}
-
-	cairo_t *c = cairo_create(dummy_surface);
-
-	cairo_set_antialias(c, CAIRO_ANTIALIAS_BEST);
 	cairo_font_options_t *fo = cairo_font_options_create();
 	cairo_font_options_set_hint_style(fo, CAIRO_HINT_STYLE_FULL);
 	cairo_font_options_set_antialias(fo, CAIRO_ANTIALIAS_SUBPIXEL);
 	cairo_font_options_set_subpixel_order(
 	    fo, to_cairo_subpixel_order(output->wlr_output->subpixel));
-	cairo_set_font_options(c, fo);
-	get_text_size(c, output->server->message_config.font, &width, &height, NULL,
-	              scale, "%s", string);
+	PangoLayout *layout = get_text_layout(
+	    message_font(&output->server->message_config), scale, fo, string);
+	cairo_font_options_destroy(fo);
+	if(layout == NULL) {
+		return NULL;
+	}
+	pango_layout_get_pixel_size(layout, &width, &height);
 	width += 2 * WIDTH_PADDING;
 	height += 2 * HEIGHT_PADDING;
-	cairo_surface_destroy(dummy_surface);
-	cairo_destroy(c);
 
-	cairo_surface_t *surface =
-	    cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+	int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
+	struct msg_buffer *buf = msg_buffer_create(
+	    &output->server->message_cache.pool, width, height, stride);
+	if(buf == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate message buffer");
+		g_object_unref(layout);
+		return NULL;
+	}
+
+	/* Draw straight into the buffer handed to the scene */
+	cairo_surface_t *surface = cairo_image_surface_create_for_data(
+	    buf->data, CAIRO_FORMAT_ARGB32, width, height, stride);
+	// This occurs when we are fuzzing. In that case, do nothing
+	if(surface == NULL) {
+		wlr_buffer_drop(&buf->base);
+		g_object_unref(layout);
+		return NULL;
+	}
 	cairo_t *cairo = cairo_create(surface);
 	cairo_set_antialias(cairo, CAIRO_ANTIALIAS_BEST);
-	cairo_set_font_options(cairo, fo);
-	cairo_font_options_destroy(fo);
 	float *bg_col = output->server->message_config.bg_color;
 	cairo_set_source_rgba(cairo, bg_col[0], bg_col[1], bg_col[2], bg_col[3]);
+	/* Buffers from the pool still hold an old message */
+	cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
 	cairo_paint(cairo);
+	cairo_set_operator(cairo, CAIRO_OPERATOR_OVER);
 	float *fg_col = output->server->message_config.fg_color;
 	cairo_set_source_rgba(cairo, fg_col[0], fg_col[1], fg_col[2], fg_col[3]);
 	cairo_set_line_width(cairo, 2);
@@ -152,30 +217,126 @@ create_message_texture(const char *string, const struct nedm_output *output) {
 	cairo_stroke(cairo);
 	cairo_move_to(cairo, WIDTH_PADDING, HEIGHT_PADDING);
 
-	pango_printf(cairo, output->server->message_config.font, scale, "%s",
-	             string);
+	pango_cairo_show_layout(cairo, layout);
+	g_object_unref(layout);
 
 	cairo_surface_flush(surface);
-	unsigned char *data = cairo_image_surface_get_data(surface);
-	int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
+	cairo_destroy(cairo);
+	cairo_surface_destroy(surface);
+	return buf;
+}
 
-	struct msg_buffer *buf = msg_buffer_create(width, height, stride);
-	void *data_ptr;
+static bool
+message_cache_entry_matches(const struct message_cache_entry *entry,
+                            const char *string,
+                            const struct nedm_output *output) {
+	const struct nedm_message_config *config = &output->server->message_config;
+	const char *font = message_font(config);
+	return entry->scale == output->wlr_output->scale &&
+	       entry->subpixel == output->wlr_output->subpixel &&
+	       memcmp(entry->bg_color, config->bg_color, sizeof(entry->bg_color)) ==
+	           0 &&
+	       memcmp(entry->fg_color, config->fg_color, sizeof(entry->fg_color)) ==
+	           0 &&
+	       strcmp(entry->font, font) == 0 && strcmp(entry->text, string) == 0;
+}
 
-	if(!wlr_buffer_begin_data_ptr_access(&buf->base,
-	                                     WLR_BUFFER_DATA_PTR_ACCESS_WRITE,
-	                                     &data_ptr, NULL, NULL)) {
-		wlr_log(WLR_ERROR, "Failed to get pointer access to message buffer");
-		return NULL;
+static void
+message_cache_entry_destroy(struct nedm_message_cache *cache,
+                            struct message_cache_entry *entry) {
+	wl_list_remove(&entry->link);
+	--cache->nentries;
+	wlr_buffer_unlock(&entry->buf->base);
+	free(entry->text);
+	free(entry->font);
+	free(entry);
+}
+
+static void
+message_cache_insert(struct nedm_message_cache *cache, const char *string,
+                     const struct nedm_output *output, struct msg_buffer *buf) {
+	const struct nedm_message_config *config = &output->server->message_config;
+	struct message_cache_entry *entry = calloc(1, sizeof(*entry));
+	if(entry == NULL) {
+		return;
+	}
+	entry->text = strdup(string);
+	entry->font = strdup(message_font(config));
+	if(entry->text == NULL || entry->font == NULL) {
+		free(entry->text);
+		free(entry->font);
+		free(entry);
+		return;
 	}
-	memcpy(data_ptr, data, stride * height);
-	wlr_buffer_end_data_ptr_access(&buf->base);
+	entry->scale = output->wlr_output->scale;
+	entry->subpixel = output->wlr_output->subpixel;
+	memcpy(entry->bg_color, config->bg_color, sizeof(entry->bg_color));
+	memcpy(entry->fg_color, config->fg_color, sizeof(entry->fg_color));
+	wlr_buffer_lock(&buf->base);
+	entry->buf = buf;
+	wl_list_insert(&cache->entries, &entry->link);
+	++cache->nentries;
+
+	if(cache->nentries > NEDM_MESSAGE_CACHE_SIZE) {
+		struct message_cache_entry *last =
+		    wl_container_of(cache->entries.prev, last, link);
+		message_cache_entry_destroy(cache, last);
+	}
+}
 
-	cairo_surface_destroy(surface);
-	cairo_destroy(cairo);
+/* Returns a locked buffer showing the message, which the caller has to unlock
+ * once it is no longer needed. */
+static struct msg_buffer *
+message_texture_get(const char *string, const struct nedm_output *output) {
+	struct nedm_message_cache *cache = &output->server->message_cache;
+	struct message_cache_entry *entry;
+	wl_list_for_each(entry, &cache->entries, link) {
+		if(message_cache_entry_matches(entry, string, output)) {
+			++cache->hits;
+			wl_list_remove(&entry->link);
+			wl_list_insert(&cache->entries, &entry->link);
+			wlr_buffer_lock(&entry->buf->base);
+			return entry->buf;
+		}
+	}
+
+	++cache->misses;
+	struct msg_buffer *buf = create_message_texture(string, output);
+	if(buf == NULL) {
+		return NULL;
+	}
+	wlr_buffer_lock(&buf->base);
+	message_cache_insert(cache, string, output, buf);
+	/* From now on, the buffer is freed as soon as its last lock is gone */
+	wlr_buffer_drop(&buf->base);
 	return buf;
 }
 
+static void
+message_destroy(struct nedm_message *message) {
+	wl_list_remove(&message->link);
+	if(message->timer != NULL) {
+		wl_event_source_remove(message->timer);
+	}
+	if(message->message != NULL) {
+		wlr_scene_node_destroy(&message->message->node);
+	}
+	free(message->position);
+	if(message->buf != NULL) {
+		wlr_buffer_unlock(&message->buf->base);
+	}
+	free(message);
+}
+
+static int
+handle_message_timeout(void *data) {
+	struct nedm_message *message = data;
+	/* Destroying the scene node only damages the area it covered */
+	++message->output->server->scene_generation;
+	message_destroy(message);
+	return 0;
+}
+
 void
 message_set_output(struct nedm_output *output, const char *string,
                    struct wlr_box *box, enum nedm_message_anchor anchor) {
@@ -185,16 +346,33 @@ message_set_output(struct nedm_output *output, const char *string,
 		free(box);
 		return;
 	}
-	struct msg_buffer *buf = create_message_texture(string, output);
+	struct msg_buffer *buf = message_texture_get(string, output);
 	if(!buf) {
 		wlr_log(WLR_ERROR, "Could not create message texture");
 		free(box);
 		free(message);
 		return;
 	}
+	message->output = output;
 	message->position = box;
+	message->message = NULL;
+	message->buf = buf;
+	message->timer = NULL;
 	wl_list_insert(&output->messages, &message->link);
 
+	/* Each message expires on its own, a display time of 0 keeps it on the
+	 * screen until the messages of the output are cleared. */
+	int display_time = output->server->message_config.display_time;
+	if(display_time > 0) {
+		message->timer = wl_event_loop_add_timer(
+		    output->server->event_loop, handle_message_timeout, message);
+		if(message->timer == NULL) {
+			wlr_log(WLR_ERROR, "Failed to create message timer");
+		} else {
+			wl_event_source_timer_update(message->timer, display_time * 1000);
+		}
+	}
+
 	double scale = output->wlr_output->scale;
 	int width = buf->base.width / scale;
 	int height = buf->base.height / scale;
@@ -238,12 +416,20 @@ message_set_output(struct nedm_output *output, const char *string,
 	if(scene_output == NULL) {
 		return;
 	}
+	++output->server->scene_generation;
 	message->message =
 	    wlr_scene_buffer_create(&scene_output->scene->tree, &buf->base);
-	message->buf = buf;
 	wlr_scene_node_raise_to_top(&message->message->node);
 	wlr_scene_node_set_enabled(&message->message->node, true);
 	wlr_scene_buffer_set_dest_size(message->message, width, height);
+	/* The background is painted over the whole buffer. If it is opaque, the
+	 * scene does not need to render older messages hidden behind this one. */
+	if(output->server->message_config.bg_color[3] >= 1.0) {
+		pixman_region32_t opaque;
+		pixman_region32_init_rect(&opaque, 0, 0, width, height);
+		wlr_scene_buffer_set_opaque_region(message->message, &opaque);
+		pixman_region32_fini(&opaque);
+	}
 	wlr_scene_node_set_position(
 	    &message->message->node,
 	    message->position->x + output_get_layout_box(output).x,
@@ -309,7 +495,6 @@ message_printf(struct nedm_output *output, const char *fmt, ...) {
 	message_set_output(output, buffer, box,
 	                   output->server->message_config.anchor);
 	free(buffer);
-	alarm(output->server->message_config.display_time);
 }
 
 void
@@ -329,19 +514,41 @@ message_printf_pos(struct nedm_output *output, struct wlr_box *position,
 
 	message_set_output(output, buffer, position, anchor);
 	free(buffer);
-	alarm(output->server->message_config.display_time);
 }
 
 void
 message_clear(struct nedm_output *output) {
 	struct nedm_message *message, *tmp;
+	if(!wl_list_empty(&output->messages)) {
+		++output->server->scene_generation;
+	}
 	wl_list_for_each_safe(message, tmp, &output->messages, link) {
-		wl_list_remove(&message->link);
-		wlr_scene_node_destroy(&message->message->node);
-		free(message->position);
-		if(message->buf != NULL) {
-			msg_buffer_destroy(&message->buf->base);
+		message_destroy(message);
+	}
+}
+
+void
+message_cache_init(struct nedm_server *server) {
+	struct nedm_message_cache *cache = &server->message_cache;
+	wl_list_init(&cache->entries);
+	cache->nentries = 0;
+	cache->hits = 0;
+	cache->misses = 0;
+	memset(&cache->pool, 0, sizeof(cache->pool));
+}
+
+void
+message_cache_finish(struct nedm_server *server) {
+	struct nedm_message_cache *cache = &server->message_cache;
+	struct message_cache_entry *entry, *tmp;
+	wl_list_for_each_safe(entry, tmp, &cache->entries, link) {
+		message_cache_entry_destroy(cache, entry);
+	}
+	struct nedm_message_pool *pool = &cache->pool;
+	for(int i = 0; i < NEDM_MESSAGE_POOL_CLASSES; ++i) {
+		while(pool->nfree[i] > 0) {
+			free(pool->data[i][--pool->nfree[i]]);
 		}
-		free(message);
 	}
+	pool->finished = true;
 }
@@ -5,9 +5,24 @@
 
 #define NEDM_MESSAGE_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <wayland-server-core.h>
 
+/* Maximum number of rendered messages kept around for reuse */
+#define NEDM_MESSAGE_CACHE_SIZE 16
+/* Message buffers are allocated from a pool with this many size classes,
+ * class i holding buffers of NEDM_MESSAGE_POOL_MIN_SIZE << i bytes. Larger
+ * buffers are not pooled. */
+#define NEDM_MESSAGE_POOL_CLASSES 8
+#define NEDM_MESSAGE_POOL_MIN_SIZE 4096
+/* Maximum number of unused buffers kept per size class */
+#define NEDM_MESSAGE_POOL_DEPTH 4
+/* Font of messages if none is configured */
+#define NEDM_MESSAGE_DEFAULT_FONT "pango:Monospace 10"
+
 struct nedm_output;
+struct nedm_server;
 struct wlr_box;
 struct wlr_buffer;
 
@@ -31,11 +46,31 @@ struct nedm_message_config {
 	enum nedm_message_anchor anchor;
 };
 
+/* Unused message buffers by size class, reused for new messages */
+struct nedm_message_pool {
+	void *data[NEDM_MESSAGE_POOL_CLASSES][NEDM_MESSAGE_POOL_DEPTH];
+	uint32_t nfree[NEDM_MESSAGE_POOL_CLASSES];
+	bool finished; // Buffers destroyed after shutdown are freed directly
+};
+
+/* Rendered messages are kept in a small LRU cache keyed by everything that
+ * influences their contents, so that repeated messages (e.g. the workspace or
+ * mode indicators) only require a new scene node. */
+struct nedm_message_cache {
+	struct wl_list entries; // message_cache_entry::link, most recent first
+	uint32_t nentries;
+	uint64_t hits;
+	uint64_t misses;
+	struct nedm_message_pool pool;
+};
+
 struct nedm_message {
+	struct nedm_output *output;
 	struct wlr_box *position;
 	struct wlr_scene_buffer *message;
 	struct wl_surface *surface;
 	struct msg_buffer *buf;
+	struct wl_event_source *timer; // NULL if the message does not expire
 	struct wl_list link;
 };
 
@@ -46,5 +81,9 @@ message_printf_pos(struct nedm_output *output, struct wlr_box *position,
                    enum nedm_message_anchor, const char *fmt, ...);
 void
 message_clear(struct nedm_output *output);
+void
+message_cache_init(struct nedm_server *server);
+void
+message_cache_finish(struct nedm_server *server);
 
 #endif /* end of include guard NEDM_MESSAGE_H */
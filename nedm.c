@@ -23,6 +23,7 @@
 #include <wlr/render/allocator.h>
 #include <wlr/render/wlr_renderer.h>
 #include <wlr/types/wlr_compositor.h>
+#include <wlr/types/wlr_content_type_v1.h>
 #include <wlr/types/wlr_cursor.h>
 #include <wlr/types/wlr_data_control_v1.h>
 #include <wlr/types/wlr_data_device.h>
@@ -55,10 +56,13 @@
 #include "layer_shell.h"
 #include "message.h"
 #include "output.h"
+#include "pango.h"
 #include "parse.h"
 #include "seat.h"
 #include "server.h"
+#include "transaction.h"
 #include "wallpaper.h"
+#include "worker.h"
 #include "workspace.h"
 #include "xdg_shell.h"
 #if NEDM_HAS_XWAYLAND
@@ -164,13 +168,6 @@ handle_signal(int signal, void *const data) {
 	case SIGTERM:
 		display_terminate(server);
 		return 0;
-	case SIGALRM: {
-		struct nedm_output *output;
-		wl_list_for_each(output, &server->outputs, link) {
-			message_clear(output);
-		}
-		return 0;
-	}
 	case SIGPIPE:
 		/* Ignore broken pipe signals */
 		wlr_log(WLR_DEBUG, "Ignoring SIGPIPE");
@@ -275,7 +272,7 @@ set_configuration(struct nedm_server *server,
 		line[strcspn(line, "\n")] = '\0';
 		if(*line != '\0' && *line != '#') {
 			char *errstr;
-			if(parse_rc_line(server, line, &errstr) != 0) {
+			if(parse_rc_line(server, line, &errstr, NULL) != 0) {
 				wlr_log(WLR_ERROR, "Error in config file \"%s\", line %d\n",
 				        config_file_path, line_num);
 				fclose(config_file);
@@ -323,7 +320,6 @@ main(int argc, char *argv[]) {
 	struct wl_event_loop *event_loop = NULL;
 	struct wl_event_source *sigint_source = NULL;
 	struct wl_event_source *sigterm_source = NULL;
-	struct wl_event_source *sigalrm_source = NULL;
 	struct wl_event_source *sigpipe_source = NULL;
 	struct wlr_backend *backend = NULL;
 	struct wlr_compositor *compositor = NULL;
@@ -355,6 +351,7 @@ main(int argc, char *argv[]) {
 	server.wallpaper_config.bg_color[1] = 0.2;
 	server.wallpaper_config.bg_color[2] = 0.3;
 	server.wallpaper_config.bg_color[3] = 1.0;
+	server.wallpaper_config.transition_time = 500;
 
 	char *config_path = NULL;
 	if(!parse_args(&server, argc, argv, &config_path)) {
@@ -438,25 +435,17 @@ main(int argc, char *argv[]) {
 	server.message_config.bg_color[3] = 1.0;
 
 	server.message_config.display_time = 2;
-	server.message_config.font = strdup("pango:Monospace 10");
+	server.message_config.font = strdup(NEDM_MESSAGE_DEFAULT_FONT);
 	server.message_config.anchor = NEDM_MESSAGE_TOP_RIGHT;
 
-
-	// Initialize wallpaper config defaults
-	server.wallpaper_config.image_path = strdup("assets/nedm.png");
-	server.wallpaper_config.mode = NEDM_WALLPAPER_FILL;
-	server.wallpaper_config.bg_color[0] = 0.2;
-	server.wallpaper_config.bg_color[1] = 0.2;
-	server.wallpaper_config.bg_color[2] = 0.3;
-	server.wallpaper_config.bg_color[3] = 1.0;
+	message_cache_init(&server);
+	nedm_wallpaper_init(&server);
 
 	event_loop = wl_display_get_event_loop(server.wl_display);
 	sigint_source =
 	    wl_event_loop_add_signal(event_loop, SIGINT, handle_signal, &server);
 	sigterm_source =
 	    wl_event_loop_add_signal(event_loop, SIGTERM, handle_signal, &server);
-	sigalrm_source =
-	    wl_event_loop_add_signal(event_loop, SIGALRM, handle_signal, &server);
 	sigpipe_source =
 	    wl_event_loop_add_signal(event_loop, SIGPIPE, handle_signal, &server);
 	server.event_loop = event_loop;
@@ -516,6 +505,16 @@ main(int argc, char *argv[]) {
 		goto end;
 	}
 
+	if(transaction_init(&server) != 0) {
+		ret = 1;
+		goto end;
+	}
+
+	if(worker_init(&server) != 0) {
+		ret = 1;
+		goto end;
+	}
+
 	server.scene = wlr_scene_create();
 	if(!server.scene) {
 		wlr_log(WLR_ERROR, "Unable to create scene");
@@ -619,6 +618,14 @@ main(int argc, char *argv[]) {
 		goto end;
 	}
 
+	server.content_type_manager =
+	    wlr_content_type_manager_v1_create(server.wl_display, 1);
+	if(!server.content_type_manager) {
+		wlr_log(WLR_ERROR, "Unable to create the content type manager");
+		ret = 1;
+		goto end;
+	}
+
 	export_dmabuf_manager =
 	    wlr_export_dmabuf_manager_v1_create(server.wl_display);
 	if(!export_dmabuf_manager) {
@@ -854,15 +861,23 @@ end:
 	if(server.wallpaper_config.image_path != NULL) {
 		free(server.wallpaper_config.image_path);
 	}
+	if(server.wallpaper_config.slideshow != NULL) {
+		free(server.wallpaper_config.slideshow);
+	}
 	server.running = false;
 	if(server.seat != NULL) {
 		seat_destroy(server.seat);
 	}
 
+	transaction_finish(&server);
+	worker_finish(&server);
+	nedm_wallpaper_finish(&server);
+	message_cache_finish(&server);
+	pango_font_cache_finish();
+
 	if(sigint_source != NULL) {
 		wl_event_source_remove(sigint_source);
 		wl_event_source_remove(sigterm_source);
-		wl_event_source_remove(sigalrm_source);
 		wl_event_source_remove(sigpipe_source);
 	}
 
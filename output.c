@@ -6,6 +6,7 @@
 #include "config.h"
 #include <wlr/config.h>
 
+#include <drm_fourcc.h>
 #include <limits.h>
 #include <string.h>
 #include <unistd.h>
@@ -16,7 +17,10 @@
 #include <wlr/backend/x11.h>
 #endif
 #include <wlr/backend/headless.h>
+#include <wlr/render/drm_format_set.h>
+#include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_compositor.h>
+#include <wlr/types/wlr_content_type_v1.h>
 #include <wlr/types/wlr_cursor.h>
 #include <wlr/types/wlr_data_device.h>
 #include <wlr/types/wlr_gamma_control_v1.h>
@@ -36,6 +40,7 @@
 #include "output.h"
 #include "seat.h"
 #include "server.h"
+#include "transaction.h"
 #include "util.h"
 #include "view.h"
 #include "wallpaper.h"
@@ -151,15 +156,21 @@ output_destroy(struct nedm_output *output) {
 		wl_list_remove(&output->destroy.link);
 		wl_list_remove(&output->commit.link);
 		wl_list_remove(&output->frame.link);
+		wl_list_remove(&output->present.link);
 		wlr_scene_output_destroy(output->scene_output);
 		output->scene_output = NULL;
 	}
+	output->render_pending = false;
+	output->last_present.tv_sec = 0;
+	output->last_present.tv_nsec = 0;
 	output->destroyed = true;
+	++server->scene_generation;
 	enum output_role role = output->role;
 	if(role == OUTPUT_ROLE_PERMANENT && server->running) {
 		output->wlr_output = wlr_headless_add_output(server->headless_backend,
 		                                             output->layout_box.width,
 		                                             output->layout_box.height);
+		output->wlr_output->data = output;
 		output->scene_output =
 		    wlr_scene_output_create(server->scene, output->wlr_output);
 		struct wlr_output_layout_output *lo =
@@ -179,11 +190,14 @@ output_destroy(struct nedm_output *output) {
 		}
 		free(output->workspaces);
 		free(output->name);
+		if(output->render_timer != NULL) {
+			wl_event_source_remove(output->render_timer);
+		}
 
 		free(output);
 	}
 	if(outp_name != NULL) {
-		ipc_send_event(server,
+		ipc_send_event(server, NEDM_IPC_EVENT_DESTROY_OUTPUT,
 		               "{\"event_name\":\"destroy_output\",\"output\":\"%s\","
 		               "\"output_id\":%d,\"permanent\":%d}",
 		               outp_name, outp_num, role == OUTPUT_ROLE_PERMANENT);
@@ -225,11 +239,326 @@ handle_output_gamma_control_set_gamma(struct wl_listener *listener,
 	}
 }
 
+static int64_t
+timespec_diff_us(const struct timespec *a, const struct timespec *b) {
+	return (int64_t)(a->tv_sec - b->tv_sec) * 1000000 +
+	       (a->tv_nsec - b->tv_nsec) / 1000;
+}
+
+static void
+histogram_add(struct nedm_histogram *hist, int64_t us) {
+	if(us < 0) {
+		us = 0;
+	}
+	uint32_t bucket = 0;
+	while(bucket < NEDM_HISTOGRAM_SIZE - 1 && (us >> (bucket + 1)) != 0) {
+		++bucket;
+	}
+	++hist->buckets[bucket];
+	++hist->count;
+	hist->total_us += us;
+	if((uint64_t)us > hist->max_us) {
+		hist->max_us = us;
+	}
+}
+
+void
+output_frame_stats_reset(struct nedm_output *output) {
+	memset(&output->frame_stats, 0, sizeof(output->frame_stats));
+}
+
+/* Returns the number of vblanks missed since the last frame */
+static int64_t
+output_frame_stats_record_frame(struct nedm_output *output,
+                                const struct timespec *now) {
+	struct nedm_frame_stats *stats = &output->frame_stats;
+	int64_t missed = 0;
+	if(stats->frames > 0) {
+		int64_t interval = timespec_diff_us(now, &stats->last_frame);
+		histogram_add(&stats->frame_interval, interval);
+		/* After a commit, the next frame event is expected at the next
+		 * vblank */
+		int32_t refresh = output->wlr_output->refresh; // mHz
+		if(stats->last_committed && refresh > 0) {
+			int64_t period = 1000000000 / refresh;
+			int64_t vblanks = (interval + period / 2) / period;
+			if(vblanks > 1) {
+				missed = vblanks - 1;
+				stats->missed_vblanks += missed;
+			}
+		}
+	}
+	++stats->frames;
+	stats->last_frame = *now;
+	return missed;
+}
+
+/* Estimate of the time in microseconds needed to render a frame, which is
+ * the time the commit is started before the predicted vblank. Returns 0 if
+ * rendering should not be delayed. */
+int64_t
+output_render_budget_us(const struct nedm_output *output) {
+	if(output->max_render_time == 0 || output->present_refresh <= 0) {
+		return 0;
+	}
+	int64_t period = output->present_refresh / 1000;
+	int64_t budget;
+	if(output->max_render_time == NEDM_MAX_RENDER_TIME_AUTO) {
+		/* Nothing has been measured yet */
+		if(output->render_time_avg_us == 0) {
+			return 0;
+		}
+		budget = output->render_time_avg_us + 4 * output->render_time_var_us +
+		         NEDM_RENDER_TIME_SLACK;
+	} else {
+		budget = (int64_t)output->max_render_time * 1000;
+	}
+	return budget < period ? budget : 0;
+}
+
+/* Update the render time estimate with the duration of a commit. This is the
+ * estimator used for round trip times in TCP (RFC 6298). */
+static void
+output_render_time_add(struct nedm_output *output, int64_t us) {
+	if(output->render_time_avg_us == 0) {
+		output->render_time_avg_us = us > 0 ? us : 1;
+		output->render_time_var_us = us / 2;
+		return;
+	}
+	int64_t err = us - output->render_time_avg_us;
+	output->render_time_avg_us += err / 8;
+	if(output->render_time_avg_us <= 0) {
+		output->render_time_avg_us = 1;
+	}
+	output->render_time_var_us +=
+	    ((err < 0 ? -err : err) - output->render_time_var_us) / 4;
+}
+
+/* Milliseconds to wait before rendering, such that the commit starts
+ * render_budget microseconds before the predicted vblank */
+static int
+output_render_delay(const struct nedm_output *output,
+                    const struct timespec *now) {
+	int64_t budget = output_render_budget_us(output);
+	if(budget == 0 || output->last_present.tv_sec == 0) {
+		return 0;
+	}
+	int64_t period = output->present_refresh / 1000;
+	int64_t since_present = timespec_diff_us(now, &output->last_present);
+	if(since_present < 0) {
+		since_present = 0;
+	}
+	int64_t until_vblank = period - since_present % period;
+	int64_t delay = until_vblank - budget;
+	/* The timer has a resolution of milliseconds, round down so as not to
+	 * miss the deadline */
+	return delay >= 1000 ? delay / 1000 : 0;
+}
+
+const char *
+output_adaptive_sync_to_str(enum nedm_adaptive_sync adaptive_sync) {
+	switch(adaptive_sync) {
+	case NEDM_ADAPTIVE_SYNC_OFF:
+		return "off";
+	case NEDM_ADAPTIVE_SYNC_ON:
+		return "on";
+	case NEDM_ADAPTIVE_SYNC_AUTO:
+		return "auto";
+	}
+	return "unknown";
+}
+
+static const char *
+content_type_to_str(enum wp_content_type_v1_type content_type) {
+	switch(content_type) {
+	case WP_CONTENT_TYPE_V1_TYPE_NONE:
+		return "none";
+	case WP_CONTENT_TYPE_V1_TYPE_PHOTO:
+		return "photo";
+	case WP_CONTENT_TYPE_V1_TYPE_VIDEO:
+		return "video";
+	case WP_CONTENT_TYPE_V1_TYPE_GAME:
+		return "game";
+	}
+	return "unknown";
+}
+
+/* Content type hint of the view in the focused tile of the current workspace
+ * if that tile fills the whole output */
+static enum wp_content_type_v1_type
+output_fullscreen_content_type(const struct nedm_output *output) {
+	struct nedm_server *server = output->server;
+	if(output->workspaces == NULL || server->content_type_manager == NULL) {
+		return WP_CONTENT_TYPE_V1_TYPE_NONE;
+	}
+	struct nedm_tile *tile =
+	    output->workspaces[output->curr_workspace]->focused_tile;
+	if(tile == NULL || tile->next != tile || tile->view == NULL ||
+	   tile->view->wlr_surface == NULL) {
+		return WP_CONTENT_TYPE_V1_TYPE_NONE;
+	}
+	return wlr_surface_get_content_type_v1(server->content_type_manager,
+	                                       tile->view->wlr_surface);
+}
+
+/* Enable or disable adaptive sync according to the configured mode. Unless
+ * force is set, the output state is only touched if the desired state changed
+ * since the last call. The change is part of the next frame commit. */
+void
+output_update_adaptive_sync(struct nedm_output *output, bool force) {
+	struct wlr_output *wlr_output = output->wlr_output;
+	if(output->destroyed || !wlr_output->enabled) {
+		return;
+	}
+	enum wp_content_type_v1_type content_type = WP_CONTENT_TYPE_V1_TYPE_NONE;
+	bool wanted = false;
+	switch(output->adaptive_sync) {
+	case NEDM_ADAPTIVE_SYNC_OFF:
+		wanted = false;
+		break;
+	case NEDM_ADAPTIVE_SYNC_ON:
+		wanted = true;
+		break;
+	case NEDM_ADAPTIVE_SYNC_AUTO:
+		content_type = output_fullscreen_content_type(output);
+		wanted = content_type == WP_CONTENT_TYPE_V1_TYPE_GAME ||
+		         content_type == WP_CONTENT_TYPE_V1_TYPE_VIDEO;
+		break;
+	}
+	if(!force && wanted == output->adaptive_sync_wanted) {
+		return;
+	}
+	output->adaptive_sync_wanted = wanted;
+	output->adaptive_sync_content_type = content_type;
+	bool enabled =
+	    wlr_output->adaptive_sync_status == WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED;
+	output->adaptive_sync_pending = wanted != enabled;
+	if(output->adaptive_sync_pending) {
+		wlr_output_schedule_frame(wlr_output);
+	}
+}
+
+/* Called after a frame which requested an adaptive sync change has been
+ * committed */
+static void
+output_adaptive_sync_committed(struct nedm_output *output, bool committed) {
+	output->adaptive_sync_pending = false;
+	bool wanted = output->adaptive_sync_wanted;
+	if(!committed || (output->wlr_output->adaptive_sync_status ==
+	                  WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED) != wanted) {
+		wlr_log(WLR_INFO, "Failed to %s adaptive sync on output %s",
+		        wanted ? "enable" : "disable", output->name);
+		return;
+	}
+	enum wp_content_type_v1_type content_type =
+	    output->adaptive_sync_content_type;
+	ipc_send_state_event(
+	    output->server, NEDM_IPC_EVENT_ADAPTIVE_SYNC, output->name,
+	    "{\"event_name\":\"adaptive_sync\",\"output\":\"%s\","
+	    "\"output_id\":%d,\"enabled\":%d,\"mode\":\"%s\","
+	    "\"content_type\":\"%s\"}",
+	    output->name, output_get_num(output), wanted,
+	    output_adaptive_sync_to_str(output->adaptive_sync),
+	    content_type_to_str(content_type));
+}
+
+static void
+output_render(struct nedm_output *output, struct timespec *now) {
+	struct wlr_scene_output *scene_output =
+	    wlr_scene_get_scene_output(output->server->scene, output->wlr_output);
+	if(scene_output == NULL) {
+		return;
+	}
+	struct nedm_frame_stats *stats = &output->frame_stats;
+	stats->last_committed = false;
+	output->render_pending = false;
+	/* Wait for clients to catch up with the new layout, a frame is scheduled
+	 * once the transaction is applied */
+	if(transaction_output_blocked(output)) {
+		return;
+	}
+	if(!wlr_scene_output_needs_frame(scene_output) &&
+	   !output->adaptive_sync_pending) {
+		++stats->skipped_commits;
+		return;
+	}
+	struct timespec start = *now;
+	struct wlr_output_state state;
+	wlr_output_state_init(&state);
+	if(wlr_scene_output_build_state(scene_output, &state, NULL)) {
+		if(output->adaptive_sync_pending) {
+			/* Toggling adaptive sync must not cost the frame */
+			wlr_output_state_set_adaptive_sync_enabled(
+			    &state, output->adaptive_sync_wanted);
+			if(!wlr_output_test_state(output->wlr_output, &state)) {
+				state.committed &= ~WLR_OUTPUT_STATE_ADAPTIVE_SYNC_ENABLED;
+			}
+		}
+		stats->last_committed =
+		    wlr_output_commit_state(output->wlr_output, &state);
+	}
+	bool adaptive_sync_committed =
+	    stats->last_committed &&
+	    (state.committed & WLR_OUTPUT_STATE_ADAPTIVE_SYNC_ENABLED);
+	wlr_output_state_finish(&state);
+	if(output->adaptive_sync_pending) {
+		output_adaptive_sync_committed(output, adaptive_sync_committed);
+	}
+	clock_gettime(CLOCK_MONOTONIC, now);
+	int64_t commit_time = timespec_diff_us(now, &start);
+	histogram_add(&stats->commit_time, commit_time);
+	if(stats->last_committed) {
+		output_render_time_add(output, commit_time);
+		/* The frame may show changes the compositor is not told about, such
+		 * as subsurfaces or override redirect windows, so a cached hit test
+		 * on this output only holds until its next frame */
+		struct nedm_seat *seat = output->server->seat;
+		struct wlr_box box = output_get_layout_box(output), intersection;
+		if(seat != NULL && seat->hit_node != NULL &&
+		   wlr_box_intersection(&intersection, &box, &seat->hit_box)) {
+			++output->server->scene_generation;
+		}
+	}
+}
+
+static int
+handle_output_render_timer(void *data) {
+	struct nedm_output *output = data;
+	if(!output->render_pending) {
+		return 0;
+	}
+	output->render_pending = false;
+	if(output->destroyed) {
+		return 0;
+	}
+	/* Set while the timer was armed, see handle_output_frame */
+	output->wlr_output->frame_pending = false;
+	if(!output->wlr_output->enabled) {
+		return 0;
+	}
+	struct timespec now = {0};
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	output_render(output, &now);
+	return 0;
+}
+
+static void
+handle_output_present(struct wl_listener *listener, void *data) {
+	struct nedm_output *output = wl_container_of(listener, output, present);
+	struct wlr_output_event_present *event = data;
+	if(!event->presented) {
+		return;
+	}
+	output->last_present = event->when;
+	output->present_refresh = event->refresh;
+}
+
 static void
 handle_output_frame(struct wl_listener *listener,
                     __attribute__((unused)) void *data) {
 	struct nedm_output *output = wl_container_of(listener, output, frame);
-	if(!output->wlr_output->enabled) {
+	/* The delayed render of the previous frame has not happened yet */
+	if(!output->wlr_output->enabled || output->render_pending) {
 		return;
 	}
 	struct wlr_scene_output *scene_output =
@@ -237,10 +566,36 @@ handle_output_frame(struct wl_listener *listener,
 	if(scene_output == NULL) {
 		return;
 	}
-	wlr_scene_output_commit(scene_output, NULL);
-
 	struct timespec now = {0};
 	clock_gettime(CLOCK_MONOTONIC, &now);
+	int64_t missed = output_frame_stats_record_frame(output, &now);
+	/* A delayed frame missed its vblank, be more conservative */
+	if(missed > 0 && output->render_delayed &&
+	   output->max_render_time == NEDM_MAX_RENDER_TIME_AUTO) {
+		output->render_time_var_us += NEDM_RENDER_TIME_SLACK;
+	}
+	output->render_delayed = false;
+
+	/* Content type hints and the focused view may have changed */
+	output_update_adaptive_sync(output, false);
+
+	int delay = output_render_delay(output, &now);
+	if(delay > 0 && output->render_timer != NULL) {
+		/* Clients get the frame done event right away, so that their
+		 * next buffers are part of the delayed commit */
+		++output->frame_stats.delayed_frames;
+		output->frame_stats.last_committed = false;
+		output->render_pending = true;
+		output->render_delayed = true;
+		/* Keeps client commits from scheduling further frame events
+		 * until the delayed frame has been rendered */
+		output->wlr_output->frame_pending = true;
+		wl_event_source_timer_update(output->render_timer, delay);
+		wlr_scene_output_send_frame_done(scene_output, &now);
+		return;
+	}
+
+	output_render(output, &now);
 	wlr_scene_output_send_frame_done(scene_output, &now);
 }
 
@@ -361,6 +716,16 @@ output_apply_config(struct nedm_server *server, struct nedm_output *output,
 		output->priority = config->priority;
 	}
 
+	if(config->max_render_time != -1) {
+		output->max_render_time = config->max_render_time;
+		output->render_time_avg_us = 0;
+		output->render_time_var_us = 0;
+	}
+
+	if(config->adaptive_sync != -1) {
+		output->adaptive_sync = config->adaptive_sync;
+	}
+
 	if(config->angle != -1) {
 		wlr_output_state_set_transform(state, config->angle);
 	}
@@ -453,6 +818,7 @@ output_apply_config(struct nedm_server *server, struct nedm_output *output,
 		}
 		wlr_output_state_set_enabled(state, true);
 		wlr_output_commit_state(wlr_output, state);
+		output_update_adaptive_sync(output, true);
 	}
 
 	if(output->bg != NULL) {
@@ -465,12 +831,19 @@ output_apply_config(struct nedm_server *server, struct nedm_output *output,
 		free(state);
 		return;
 	}
-	output->bg = wlr_scene_rect_create(
-	    &scene_output->scene->tree, output->wlr_output->width,
-	    output->wlr_output->height, server->bg_color);
+	/* The size of the background has to be given in layout coordinates,
+	 * otherwise it extends to neighbouring outputs if the output is scaled */
+	int bg_width, bg_height;
+	wlr_output_effective_resolution(output->wlr_output, &bg_width, &bg_height);
+	output->bg = wlr_scene_rect_create(&scene_output->scene->tree, bg_width,
+	                                   bg_height, server->bg_color);
 	wlr_scene_node_set_position(&output->bg->node, scene_output->x,
 	                            scene_output->y);
 	wlr_scene_node_lower_to_bottom(&output->bg->node);
+	/* The output may have moved without a commit */
+	if(output->wallpaper != NULL) {
+		nedm_wallpaper_render(output->wallpaper);
+	}
 	free(state);
 }
 
@@ -493,6 +866,8 @@ empty_output_config(void) {
 	cfg->priority = -1;
 	cfg->scale = -1;
 	cfg->angle = -1;
+	cfg->max_render_time = -1;
+	cfg->adaptive_sync = -1;
 
 	return cfg;
 }
@@ -552,6 +927,16 @@ merge_output_configs(struct nedm_output_config *cfg1,
 	} else {
 		out_cfg->angle = cfg1->angle;
 	}
+	if(cfg1->max_render_time == out_cfg->max_render_time) {
+		out_cfg->max_render_time = cfg2->max_render_time;
+	} else {
+		out_cfg->max_render_time = cfg1->max_render_time;
+	}
+	if(cfg1->adaptive_sync == out_cfg->adaptive_sync) {
+		out_cfg->adaptive_sync = cfg2->adaptive_sync;
+	} else {
+		out_cfg->adaptive_sync = cfg1->adaptive_sync;
+	}
 	return out_cfg;
 }
 
@@ -579,6 +964,175 @@ output_configure(struct nedm_server *server, struct nedm_output *output) {
 	free(tot_config);
 }
 
+const char *
+output_composite_reason_to_str(enum nedm_composite_reason reason) {
+	switch(reason) {
+	case NEDM_COMPOSITE_NONE:
+		return "none";
+	case NEDM_COMPOSITE_LAYOUT:
+		return "layout";
+	case NEDM_COMPOSITE_MESSAGE:
+		return "message";
+	case NEDM_COMPOSITE_LAYER_SURFACE:
+		return "layer_surface";
+	case NEDM_COMPOSITE_BACKGROUND:
+		return "background";
+	case NEDM_COMPOSITE_FORMAT:
+		return "format";
+	case NEDM_COMPOSITE_OTHER:
+		return "other";
+	case NEDM_COMPOSITE_REASON_COUNT:
+		break;
+	}
+	return "unknown";
+}
+
+static bool
+scene_tree_has_enabled_children(const struct wlr_scene_tree *tree) {
+	struct wlr_scene_node *child;
+	wl_list_for_each(child, &tree->children, link) {
+		if(child->enabled) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool
+buffer_format_is_opaque(struct wlr_buffer *buffer) {
+	struct wlr_dmabuf_attributes dmabuf;
+	struct wlr_shm_attributes shm;
+	uint32_t format;
+	if(wlr_buffer_get_dmabuf(buffer, &dmabuf)) {
+		format = dmabuf.format;
+	} else if(wlr_buffer_get_shm(buffer, &shm)) {
+		format = shm.format;
+	} else {
+		return false;
+	}
+	switch(format) {
+	case DRM_FORMAT_XRGB8888:
+	case DRM_FORMAT_XBGR8888:
+	case DRM_FORMAT_RGBX8888:
+	case DRM_FORMAT_BGRX8888:
+	case DRM_FORMAT_XRGB2101010:
+	case DRM_FORMAT_XBGR2101010:
+	case DRM_FORMAT_RGBX1010102:
+	case DRM_FORMAT_BGRX1010102:
+	case DRM_FORMAT_XRGB16161616F:
+	case DRM_FORMAT_XBGR16161616F:
+	case DRM_FORMAT_RGB565:
+	case DRM_FORMAT_BGR565:
+	case DRM_FORMAT_RGB888:
+	case DRM_FORMAT_BGR888:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* The only surface that can be scanned out is the one of the view in the sole
+ * tile of the current workspace */
+static struct wlr_surface *
+output_scanout_candidate(struct nedm_output *output) {
+	struct nedm_tile *tile =
+	    output->workspaces[output->curr_workspace]->focused_tile;
+	if(tile == NULL || tile->next != tile || tile->view == NULL ||
+	   !view_is_visible(tile->view)) {
+		return NULL;
+	}
+	return tile->view->wlr_surface;
+}
+
+/* Determine why the scene of an output could not be scanned out directly.
+ * This mirrors the conditions of wlr_scene: only a single opaque buffer
+ * covering the whole output can be scanned out. */
+static enum nedm_composite_reason
+output_composite_reason(struct nedm_output *output) {
+	struct nedm_message *message;
+	wl_list_for_each(message, &output->messages, link) {
+		if(message->message != NULL && message->message->node.enabled) {
+			return NEDM_COMPOSITE_MESSAGE;
+		}
+	}
+	/* Layer surfaces in the background and bottom layers are below the
+	 * view, so they are covered if the view is opaque */
+	if(scene_tree_has_enabled_children(output->layers[2]) ||
+	   scene_tree_has_enabled_children(output->layers[3])) {
+		return NEDM_COMPOSITE_LAYER_SURFACE;
+	}
+
+	struct wlr_surface *surface = output_scanout_candidate(output);
+	if(surface == NULL) {
+		return NEDM_COMPOSITE_LAYOUT;
+	}
+
+	struct nedm_tile *tile =
+	    output->workspaces[output->curr_workspace]->focused_tile;
+	struct wlr_box box = output_get_layout_box(output);
+	int lx, ly;
+	wlr_scene_node_coords(&tile->view->scene_tree->node, &lx, &ly);
+	if(surface->buffer == NULL || lx > box.x || ly > box.y ||
+	   lx + surface->current.width < box.x + box.width ||
+	   ly + surface->current.height < box.y + box.height) {
+		return NEDM_COMPOSITE_BACKGROUND;
+	}
+	pixman_box32_t surface_box = {
+	    .x1 = 0,
+	    .y1 = 0,
+	    .x2 = surface->current.width,
+	    .y2 = surface->current.height,
+	};
+	if(!buffer_format_is_opaque(&surface->buffer->base) &&
+	   pixman_region32_contains_rectangle(&surface->opaque_region,
+	                                      &surface_box) != PIXMAN_REGION_IN) {
+		return NEDM_COMPOSITE_BACKGROUND;
+	}
+	/* Only DMA-BUFs in a format and modifier supported by the primary plane
+	 * can be scanned out */
+	struct wlr_dmabuf_attributes dmabuf;
+	const struct wlr_drm_format_set *formats = wlr_output_get_primary_formats(
+	    output->wlr_output, WLR_BUFFER_CAP_DMABUF);
+	if(formats != NULL &&
+	   wlr_buffer_get_dmabuf(&surface->buffer->base, &dmabuf)) {
+		const struct wlr_drm_format *format =
+		    wlr_drm_format_set_get(formats, dmabuf.format);
+		if(format == NULL || !wlr_drm_format_has(format, dmabuf.modifier)) {
+			return NEDM_COMPOSITE_FORMAT;
+		}
+	}
+	/* E.g. subsurfaces, a software cursor, a transform or buffer scale
+	 * mismatch or a failed test commit */
+	return NEDM_COMPOSITE_OTHER;
+}
+
+/* A frame was scanned out directly if the committed buffer is the one of the
+ * scanout candidate instead of having been rendered by the compositor */
+static void
+output_record_scanout(struct nedm_output *output, struct wlr_buffer *buffer) {
+	struct nedm_frame_stats *stats = &output->frame_stats;
+	struct wlr_surface *surface = output_scanout_candidate(output);
+	enum nedm_composite_reason reason = NEDM_COMPOSITE_NONE;
+	if(buffer != NULL && surface != NULL && surface->buffer != NULL &&
+	   buffer == &surface->buffer->base) {
+		++stats->scanout_frames;
+	} else {
+		reason = output_composite_reason(output);
+		++stats->composited_frames;
+		++stats->composite_reasons[reason];
+	}
+	if(reason != output->composite_reason) {
+		output->composite_reason = reason;
+		ipc_send_state_event(
+		    output->server, NEDM_IPC_EVENT_SCANOUT, output->name,
+		    "{\"event_name\":\"scanout\",\"output\":\"%s\","
+		    "\"output_id\":%d,\"direct\":%d,\"reason\":\"%s\"}",
+		    output->name, output_get_num(output),
+		    reason == NEDM_COMPOSITE_NONE,
+		    output_composite_reason_to_str(reason));
+	}
+}
+
 static void
 handle_output_commit(struct wl_listener *listener, void *data) {
 	struct nedm_output *output = wl_container_of(listener, output, commit);
@@ -588,9 +1142,18 @@ handle_output_commit(struct wl_listener *listener, void *data) {
 		return;
 	}
 
+	if(event->state->committed & WLR_OUTPUT_STATE_BUFFER) {
+		output_record_scanout(output, event->state->buffer);
+	}
+
 	if(event->state->committed &
 	   (WLR_OUTPUT_STATE_TRANSFORM | WLR_OUTPUT_STATE_SCALE |
 	    WLR_OUTPUT_STATE_MODE)) {
+		/* Only the scaled wallpaper is regenerated (on the worker), the
+		 * decoded image is reused */
+		if(output->wallpaper != NULL) {
+			nedm_wallpaper_render(output->wallpaper);
+		}
 		struct nedm_view *view;
 		wl_list_for_each(
 		    view, &output->workspaces[output->curr_workspace]->views, link) {
@@ -678,6 +1241,8 @@ handle_new_output(struct wl_listener *listener, void *data) {
 	output->layers[3] = wlr_scene_tree_create(&output->scene_output->scene->tree); // ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY
 
 	output->wlr_output = wlr_output;
+	wlr_output->data = output;
+	++server->scene_generation;
 	output->destroyed = false;
 	output->wallpaper = NULL;
 	wl_signal_init(&output->events.destroy);
@@ -705,6 +1270,16 @@ handle_new_output(struct wl_listener *listener, void *data) {
 
 		wl_list_init(&output->messages);
 
+		output->composite_reason = NEDM_COMPOSITE_LAYOUT;
+		output->render_timer = wl_event_loop_add_timer(
+		    server->event_loop, handle_output_render_timer, output);
+		if(output->render_timer == NULL) {
+			wlr_log(WLR_ERROR,
+			        "Failed to create render timer for output '%s', frames "
+			        "will not be delayed",
+			        output->name);
+		}
+
 		if(!wlr_xcursor_manager_load(server->seat->xcursor_manager,
 		                             wlr_output->scale)) {
 			wlr_log(WLR_ERROR,
@@ -775,10 +1350,12 @@ handle_new_output(struct wl_listener *listener, void *data) {
 	wl_signal_add(&wlr_output->events.destroy, &output->destroy);
 	output->frame.notify = handle_output_frame;
 	wl_signal_add(&wlr_output->events.frame, &output->frame);
+	output->present.notify = handle_output_present;
+	wl_signal_add(&wlr_output->events.present, &output->present);
 	output->commit.notify = handle_output_commit;
 	wl_signal_add(&wlr_output->events.commit, &output->commit);
 
-	ipc_send_event(server,
+	ipc_send_event(server, NEDM_IPC_EVENT_NEW_OUTPUT,
 	               "{\"event_name\":\"new_output\",\"output\":\"%s\",\"output_"
 	               "id\":%d,\"priority\":%d,\"restart\":%d}",
 	               output->name, output_get_num(output), output->priority,
@@ -4,6 +4,9 @@
 #ifndef NEDM_OUTPUT_H
 #define NEDM_OUTPUT_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
 #include <wayland-server-core.h>
 #include <wlr/util/box.h>
 
@@ -19,6 +22,54 @@ enum output_role {
 	OUTPUT_ROLE_DEFAULT
 };
 
+#define NEDM_HISTOGRAM_SIZE 16
+
+/* Value of max_render_time which lets the compositor estimate the render time
+ * of an output from the measured commit times */
+#define NEDM_MAX_RENDER_TIME_AUTO -2
+/* Safety margin in microseconds added to the estimated render time */
+#define NEDM_RENDER_TIME_SLACK 1000
+
+/* Histogram of durations in microseconds. Bucket i counts the durations d with
+ * 2^i <= d < 2^(i+1), where the first and the last bucket are open ended. */
+struct nedm_histogram {
+	uint64_t buckets[NEDM_HISTOGRAM_SIZE];
+	uint64_t count;
+	uint64_t total_us;
+	uint64_t max_us;
+};
+
+/* Why a frame had to be composited instead of being scanned out directly */
+enum nedm_composite_reason {
+	NEDM_COMPOSITE_NONE, // The frame was scanned out directly
+	/* The focused tile does not fill the output or shows no view */
+	NEDM_COMPOSITE_LAYOUT,
+	NEDM_COMPOSITE_MESSAGE,       // A message is shown on the output
+	NEDM_COMPOSITE_LAYER_SURFACE, // A layer surface is shown above the view
+	/* The view does not cover the output or is not opaque, so that the
+	 * wallpaper or the background is visible */
+	NEDM_COMPOSITE_BACKGROUND,
+	/* The display does not support the format or modifier of the buffer of
+	 * the view */
+	NEDM_COMPOSITE_FORMAT,
+	NEDM_COMPOSITE_OTHER, // None of the above could be determined
+	NEDM_COMPOSITE_REASON_COUNT
+};
+
+struct nedm_frame_stats {
+	struct nedm_histogram commit_time;    // Time spent committing the scene
+	struct nedm_histogram frame_interval; // Time between frame events
+	uint64_t frames;
+	uint64_t skipped_commits; // Frames without damage
+	uint64_t missed_vblanks;
+	uint64_t delayed_frames; // Frames rendered shortly before the vblank
+	uint64_t scanout_frames;
+	uint64_t composited_frames;
+	uint64_t composite_reasons[NEDM_COMPOSITE_REASON_COUNT];
+	bool last_committed;
+	struct timespec last_frame;
+};
+
 struct nedm_output {
 	struct nedm_server *server;
 	struct wlr_output *wlr_output;
@@ -28,6 +79,7 @@ struct nedm_output {
 	struct wl_listener commit;
 	struct wl_listener destroy;
 	struct wl_listener frame;
+	struct wl_listener present;
 	struct nedm_workspace **workspaces;
 	struct wl_list messages;
 	struct wlr_box layout_box;
@@ -39,6 +91,29 @@ struct nedm_output {
 	
 	struct wlr_scene_tree *layers[4]; // ZWLR_LAYER_SHELL_V1_LAYER_*
 	struct nedm_wallpaper *wallpaper;
+	struct nedm_frame_stats frame_stats;
+
+	/* Rendering is delayed until max_render_time milliseconds before the
+	 * predicted vblank, 0 disables delaying */
+	int max_render_time;
+	struct wl_event_source *render_timer;
+	bool render_pending;         // The render timer is armed
+	bool render_delayed;         // The last frame was rendered by the timer
+	struct timespec last_present;
+	int present_refresh;         // Refresh period in nanoseconds
+	int64_t render_time_avg_us;  // Smoothed commit time
+	int64_t render_time_var_us;  // Smoothed deviation of the commit time
+
+	enum nedm_adaptive_sync adaptive_sync;
+	/* Whether adaptive sync was requested the last time the state of the
+	 * output was updated, to avoid retrying a failed request every frame */
+	bool adaptive_sync_wanted;
+	/* The adaptive sync state is changed with the next rendered frame */
+	bool adaptive_sync_pending;
+	int adaptive_sync_content_type; // enum wp_content_type_v1_type
+
+	/* Reason the last frame was composited */
+	enum nedm_composite_reason composite_reason;
 	struct {
 		struct wl_signal destroy;
 	} events;
@@ -54,6 +129,13 @@ struct nedm_output_priorities {
 
 enum output_status { OUTPUT_ENABLE, OUTPUT_DISABLE, OUTPUT_DEFAULT };
 
+enum nedm_adaptive_sync {
+	NEDM_ADAPTIVE_SYNC_OFF,
+	NEDM_ADAPTIVE_SYNC_ON,
+	/* Enabled if the focused fullscreen tile shows a game or a video */
+	NEDM_ADAPTIVE_SYNC_AUTO
+};
+
 struct nedm_output_config {
 	enum output_status status;
 	enum output_role role;
@@ -63,6 +145,8 @@ struct nedm_output_config {
 	float scale;
 	int priority;
 	int angle;           // enum wl_output_transform, -1 signifies "unspecified"
+	int max_render_time; // in milliseconds, -1 signifies "unspecified"
+	int adaptive_sync;   // enum nedm_adaptive_sync, -1 signifies "unspecified"
 	struct wl_list link; // nedm_server::output_config
 };
 
@@ -86,4 +170,14 @@ void
 handle_output_gamma_control_set_gamma(struct wl_listener *listener, void *data);
 void
 output_insert(struct nedm_server *server, struct nedm_output *output);
+void
+output_frame_stats_reset(struct nedm_output *output);
+int64_t
+output_render_budget_us(const struct nedm_output *output);
+void
+output_update_adaptive_sync(struct nedm_output *output, bool force);
+const char *
+output_adaptive_sync_to_str(enum nedm_adaptive_sync adaptive_sync);
+const char *
+output_composite_reason_to_str(enum nedm_composite_reason reason);
 #endif
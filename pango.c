@@ -4,10 +4,14 @@
 #include <cairo.h>
 #include <cairo/cairo.h>
 #include <pango/pangocairo.h>
-#include <stdarg.h>
-#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-util.h>
 #include <wlr/util/log.h>
 
+#include "pango.h"
+
 char *
 lenient_strcat(char *dest, const char *src) {
 	if(dest && src) {
@@ -16,78 +20,105 @@ lenient_strcat(char *dest, const char *src) {
 	return dest;
 }
 
-PangoLayout *
-get_pango_layout(cairo_t *cairo, const char *font, const char *text,
-                 double scale) {
-	PangoLayout *layout = pango_cairo_create_layout(cairo);
-	PangoAttrList *attrs;
+struct font_cache_entry {
+	char *font;
+	double scale;
+	cairo_font_options_t *options;
+	PangoFontDescription *desc;
+	PangoContext *context; // Font options and description already set
+	PangoAttrList *attrs;  // Scales the text to the output scale
+	struct wl_list link;
+};
 
-	attrs = pango_attr_list_new();
-	pango_layout_set_text(layout, text, -1);
+/* Most recently used fonts first */
+static struct wl_list font_cache = {&font_cache, &font_cache};
+static uint32_t font_cache_size = 0;
 
-	pango_attr_list_insert(attrs, pango_attr_scale_new(scale));
-	PangoFontDescription *desc = pango_font_description_from_string(font);
-	pango_layout_set_font_description(layout, desc);
-	pango_layout_set_single_paragraph_mode(layout, false);
-	pango_layout_set_attributes(layout, attrs);
-	pango_attr_list_unref(attrs);
-	pango_font_description_free(desc);
-	return layout;
+static void
+font_cache_entry_destroy(struct font_cache_entry *entry) {
+	wl_list_remove(&entry->link);
+	--font_cache_size;
+	pango_attr_list_unref(entry->attrs);
+	g_object_unref(entry->context);
+	pango_font_description_free(entry->desc);
+	cairo_font_options_destroy(entry->options);
+	free(entry->font);
+	free(entry);
 }
 
-void
-get_text_size(cairo_t *cairo, const char *font, int *width, int *height,
-              int *baseline, double scale, const char *fmt, ...) {
-	va_list args;
-	va_start(args, fmt);
-	// Add one since vsnprintf excludes null terminator.
-	int length = vsnprintf(NULL, 0, fmt, args) + 1;
-	va_end(args);
+static struct font_cache_entry *
+font_cache_entry_create(const char *font, double scale,
+                        const cairo_font_options_t *options) {
+	struct font_cache_entry *entry = calloc(1, sizeof(*entry));
+	if(entry == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate font cache entry");
+		return NULL;
+	}
+	entry->font = strdup(font);
+	if(entry->font == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate font cache entry");
+		free(entry);
+		return NULL;
+	}
+	entry->scale = scale;
+	entry->options = cairo_font_options_copy(options);
+	entry->desc = pango_font_description_from_string(font);
+	entry->context =
+	    pango_font_map_create_context(pango_cairo_font_map_get_default());
+	pango_cairo_context_set_font_options(entry->context, entry->options);
+	pango_context_set_font_description(entry->context, entry->desc);
+	entry->attrs = pango_attr_list_new();
+	pango_attr_list_insert(entry->attrs, pango_attr_scale_new(scale));
+	return entry;
+}
 
-	char *buf = malloc(length);
-	if(buf == NULL) {
-		wlr_log(WLR_ERROR, "Failed to allocate memory");
-		return;
+static struct font_cache_entry *
+font_cache_get(const char *font, double scale,
+               const cairo_font_options_t *options) {
+	struct font_cache_entry *entry;
+	wl_list_for_each(entry, &font_cache, link) {
+		if(entry->scale == scale && strcmp(entry->font, font) == 0 &&
+		   cairo_font_options_equal(entry->options, options)) {
+			wl_list_remove(&entry->link);
+			wl_list_insert(&font_cache, &entry->link);
+			return entry;
+		}
 	}
-	va_start(args, fmt);
-	vsnprintf(buf, length, fmt, args);
-	va_end(args);
 
-	PangoLayout *layout = get_pango_layout(cairo, font, buf, scale);
-	pango_cairo_update_layout(cairo, layout);
-	pango_layout_get_pixel_size(layout, width, height);
-	if(baseline) {
-		*baseline = pango_layout_get_baseline(layout) / PANGO_SCALE;
+	entry = font_cache_entry_create(font, scale, options);
+	if(entry == NULL) {
+		return NULL;
+	}
+	wl_list_insert(&font_cache, &entry->link);
+	++font_cache_size;
+	if(font_cache_size > NEDM_FONT_CACHE_SIZE) {
+		struct font_cache_entry *last =
+		    wl_container_of(font_cache.prev, last, link);
+		font_cache_entry_destroy(last);
 	}
-	g_object_unref(layout);
-	free(buf);
+	return entry;
 }
 
-void
-pango_printf(cairo_t *cairo, const char *font, double scale, const char *fmt,
-             ...) {
-	va_list args;
-	va_start(args, fmt);
-	// Add one since vsnprintf excludes null terminator.
-	int length = vsnprintf(NULL, 0, fmt, args) + 1;
-	va_end(args);
-
-	char *buf = malloc(length);
-	if(buf == NULL) {
-		wlr_log(WLR_ERROR, "Failed to allocate memory");
-		return;
+/* Lays out the text in the given font. The same layout is used to measure the
+ * text and to draw it using pango_cairo_show_layout. */
+PangoLayout *
+get_text_layout(const char *font, double scale,
+                const cairo_font_options_t *options, const char *text) {
+	struct font_cache_entry *entry = font_cache_get(font, scale, options);
+	if(entry == NULL) {
+		return NULL;
 	}
-	va_start(args, fmt);
-	vsnprintf(buf, length, fmt, args);
-	va_end(args);
+	PangoLayout *layout = pango_layout_new(entry->context);
+	pango_layout_set_text(layout, text, -1);
+	pango_layout_set_single_paragraph_mode(layout, false);
+	pango_layout_set_attributes(layout, entry->attrs);
+	return layout;
+}
 
-	PangoLayout *layout = get_pango_layout(cairo, font, buf, scale);
-	cairo_font_options_t *fo = cairo_font_options_create();
-	cairo_get_font_options(cairo, fo);
-	pango_cairo_context_set_font_options(pango_layout_get_context(layout), fo);
-	cairo_font_options_destroy(fo);
-	pango_cairo_update_layout(cairo, layout);
-	pango_cairo_show_layout(cairo, layout);
-	g_object_unref(layout);
-	free(buf);
+void
+pango_font_cache_finish(void) {
+	struct font_cache_entry *entry, *tmp;
+	wl_list_for_each_safe(entry, tmp, &font_cache, link) {
+		font_cache_entry_destroy(entry);
+	}
 }
@@ -4,12 +4,16 @@
 #ifndef NEDM_PANGO_H
 #define NEDM_PANGO_H
 #include <cairo/cairo.h>
+#include <pango/pangocairo.h>
 
+/* Maximum number of parsed fonts kept around. The pango context of a font
+ * also caches the loaded fontset and its metrics. */
+#define NEDM_FONT_CACHE_SIZE 4
+
+PangoLayout *
+get_text_layout(const char *font, double scale,
+                const cairo_font_options_t *options, const char *text);
 void
-get_text_size(cairo_t *cairo, const char *font, int *width, int *height,
-              int *baseline, double scale, const char *fmt, ...);
-void
-pango_printf(cairo_t *cairo, const char *font, double scale, const char *fmt,
-             ...);
+pango_font_cache_finish(void);
 
 #endif
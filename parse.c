@@ -501,6 +501,20 @@ parse_cursor(char **saveptr, char **errstr) {
 	}
 }
 
+int
+parse_cursor_coalesce(char **saveptr, char **errstr) {
+	if(strcmp(*saveptr, "enable") == 0) {
+		return 1;
+	} else if(strcmp(*saveptr, "disable") == 0) {
+		return 0;
+	} else {
+		*errstr = log_error("Invalid option \"%s\" for \"cursor_coalesce\". "
+		                    "Expected \"enable\" or \"disable\".",
+		                    *saveptr);
+		return -1;
+	}
+}
+
 char *
 parse_definemode(char **saveptr, char **errstr) {
 	char *mode = strtok_r(NULL, " ", saveptr);
@@ -528,6 +542,51 @@ parse_workspaces(char **saveptr, char **errstr) {
 	return nws;
 }
 
+/* Parses "get <query> [<arguments>]" into query[0] (the kind of query) and
+ * the arguments query[1] and query[2] */
+int
+parse_get(uint32_t *query, char **saveptr, char **errstr) {
+	char *query_str = strtok_r(NULL, " ", saveptr);
+	if(query_str == NULL) {
+		*errstr = log_error("Expected \"outputs\", \"workspace\", \"view\" or "
+		                    "\"focused\" after \"get\". Got nothing.");
+		return -1;
+	}
+	if(strcmp(query_str, "outputs") == 0) {
+		query[0] = NEDM_QUERY_OUTPUTS;
+	} else if(strcmp(query_str, "focused") == 0) {
+		query[0] = NEDM_QUERY_FOCUSED;
+	} else if(strcmp(query_str, "view") == 0) {
+		query[0] = NEDM_QUERY_VIEW;
+		char *view_id_str = strtok_r(NULL, " ", saveptr);
+		long view_id = view_id_str == NULL ? 0 : strtol(view_id_str, NULL, 10);
+		if(view_id < 1) {
+			*errstr = log_error("Expected a view id larger or equal to 1 "
+			                    "after \"get view\".");
+			return -1;
+		}
+		query[1] = view_id;
+	} else if(strcmp(query_str, "workspace") == 0) {
+		query[0] = NEDM_QUERY_WORKSPACE;
+		char *outp_str = strtok_r(NULL, " ", saveptr);
+		char *ws_str = strtok_r(NULL, " ", saveptr);
+		long outp = outp_str == NULL ? 0 : strtol(outp_str, NULL, 10);
+		long ws = ws_str == NULL ? 0 : strtol(ws_str, NULL, 10);
+		if(outp < 1 || ws < 1) {
+			*errstr = log_error("Expected an output id and a workspace number, "
+			                    "both larger or equal to 1, after \"get "
+			                    "workspace\".");
+			return -1;
+		}
+		query[1] = outp;
+		query[2] = ws;
+	} else {
+		*errstr = log_error("Unknown query \"%s\" for \"get\"", query_str);
+		return -1;
+	}
+	return 0;
+}
+
 int
 parse_output_config_keyword(char *key_str, enum output_status *status) {
 	if(key_str == NULL) {
@@ -541,6 +600,10 @@ parse_output_config_keyword(char *key_str, enum output_status *status) {
 		*status = OUTPUT_DEFAULT;
 	} else if(strcmp(key_str, "scale") == 0) {
 		*status = OUTPUT_DEFAULT;
+	} else if(strcmp(key_str, "max_render_time") == 0) {
+		*status = OUTPUT_DEFAULT;
+	} else if(strcmp(key_str, "adaptive_sync") == 0) {
+		*status = OUTPUT_DEFAULT;
 	} else if(strcmp(key_str, "enable") == 0) {
 		*status = OUTPUT_ENABLE;
 	} else if(strcmp(key_str, "permanent") == 0) {
@@ -570,6 +633,8 @@ parse_output_config(char **saveptr, char **errstr) {
 	cfg->priority = -1;
 	cfg->scale = -1;
 	cfg->angle = -1;
+	cfg->max_render_time = -1;
+	cfg->adaptive_sync = -1;
 	cfg->role = OUTPUT_ROLE_DEFAULT;
 	char *name = strtok_r(NULL, " ", saveptr);
 	if(name == NULL) {
@@ -580,8 +645,10 @@ parse_output_config(char **saveptr, char **errstr) {
 	char *key_str = strtok_r(NULL, " ", saveptr);
 	if(parse_output_config_keyword(key_str, &(cfg->status)) != 0) {
 		*errstr = log_error("Expected keyword \"pos\", \"prio\", \"enable\", "
-		                    "\"disable\", \"permanent\" or \"peripheral\" in "
-		                    "output configuration for output %s",
+		                    "\"disable\", \"permanent\", \"peripheral\", "
+		                    "\"rotate\", \"scale\", \"max_render_time\" or "
+		                    "\"adaptive_sync\" in output configuration for "
+		                    "output %s",
 		                    name);
 		goto error;
 	}
@@ -628,6 +695,53 @@ parse_output_config(char **saveptr, char **errstr) {
 		return cfg;
 	}
 
+	if(strcmp(key_str, "max_render_time") == 0) {
+		char *value = strtok_r(NULL, " ", saveptr);
+		if(value == NULL) {
+			*errstr = log_error("Expected \"off\", \"auto\" or a number of "
+			                    "milliseconds for max_render_time of output %s",
+			                    name);
+			goto error;
+		}
+		if(strcmp(value, "off") == 0) {
+			cfg->max_render_time = 0;
+		} else if(strcmp(value, "auto") == 0) {
+			cfg->max_render_time = NEDM_MAX_RENDER_TIME_AUTO;
+		} else {
+			char *end = NULL;
+			long ms = strtol(value, &end, 10);
+			if(*end != '\0' || ms <= 0 || ms > 1000) {
+				*errstr = log_error(
+				    "Error parsing max_render_time of output %s, expected "
+				    "\"off\", \"auto\" or a number of milliseconds between 1 "
+				    "and 1000",
+				    name);
+				goto error;
+			}
+			cfg->max_render_time = ms;
+		}
+		cfg->output_name = strdup(name);
+		return cfg;
+	}
+
+	if(strcmp(key_str, "adaptive_sync") == 0) {
+		char *value = strtok_r(NULL, " ", saveptr);
+		if(value != NULL && strcmp(value, "on") == 0) {
+			cfg->adaptive_sync = NEDM_ADAPTIVE_SYNC_ON;
+		} else if(value != NULL && strcmp(value, "off") == 0) {
+			cfg->adaptive_sync = NEDM_ADAPTIVE_SYNC_OFF;
+		} else if(value != NULL && strcmp(value, "auto") == 0) {
+			cfg->adaptive_sync = NEDM_ADAPTIVE_SYNC_AUTO;
+		} else {
+			*errstr = log_error("Expected \"on\", \"off\" or \"auto\" for "
+			                    "adaptive_sync of output %s",
+			                    name);
+			goto error;
+		}
+		cfg->output_name = strdup(name);
+		return cfg;
+	}
+
 	if(strcmp(key_str, "peripheral") == 0) {
 		cfg->output_name = strdup(name);
 		cfg->role = OUTPUT_ROLE_PERIPHERAL;
@@ -809,10 +923,13 @@ parse_wallpaper_config(char **saveptr, char **errstr) {
 		goto error;
 	}
 
-	// Set defaults
-	cfg->image_path = strdup("assets/nedm.png");
-	cfg->mode = NEDM_WALLPAPER_FILL;
-	cfg->bg_color[0] = 0.2f; cfg->bg_color[1] = 0.2f; cfg->bg_color[2] = 0.3f; cfg->bg_color[3] = 1.0f;
+	// Settings which are not given keep their current value
+	cfg->image_path = NULL;
+	cfg->mode = NEDM_WALLPAPER_NOPT;
+	cfg->bg_color[0] = -1;
+	cfg->slideshow = NULL;
+	cfg->slideshow_interval = -1;
+	cfg->transition_time = -1;
 
 	char *setting = strtok_r(NULL, " ", saveptr);
 	if(setting == NULL) {
@@ -821,7 +938,11 @@ parse_wallpaper_config(char **saveptr, char **errstr) {
 	}
 
 	if(strcmp(setting, "image_path") == 0) {
-		free(cfg->image_path);
+		if(*saveptr == NULL || **saveptr == '\0') {
+			*errstr = log_error(
+			    "Expected image path for wallpaper configuration, got none");
+			goto error;
+		}
 		cfg->image_path = strdup(*saveptr);
 		if(cfg->image_path == NULL) {
 			*errstr = log_error("Unable to allocate memory for image path in wallpaper config");
@@ -851,6 +972,35 @@ parse_wallpaper_config(char **saveptr, char **errstr) {
 		if(parse_background(cfg->bg_color, saveptr, errstr) != 0) {
 			goto error;
 		}
+		cfg->bg_color[3] = 1.0f;
+	} else if(strcmp(setting, "slideshow") == 0) {
+		if(*saveptr == NULL || **saveptr == '\0') {
+			*errstr = log_error(
+			    "Expected images for wallpaper slideshow, got none");
+			goto error;
+		}
+		cfg->slideshow = strdup(*saveptr);
+		if(cfg->slideshow == NULL) {
+			*errstr = log_error(
+			    "Unable to allocate memory for wallpaper slideshow");
+			goto error;
+		}
+	} else if(strcmp(setting, "slideshow_interval") == 0) {
+		cfg->slideshow_interval = parse_uint(saveptr, " ");
+		if(cfg->slideshow_interval < 0) {
+			*errstr = log_error(
+			    "Error parsing command \"configure_wallpaper "
+			    "slideshow_interval\", expected a non-negative integer");
+			goto error;
+		}
+	} else if(strcmp(setting, "transition_time") == 0) {
+		cfg->transition_time = parse_uint(saveptr, " ");
+		if(cfg->transition_time < 0) {
+			*errstr = log_error(
+			    "Error parsing command \"configure_wallpaper "
+			    "transition_time\", expected a non-negative integer");
+			goto error;
+		}
 	} else {
 		*errstr = log_error("Unknown wallpaper setting: \"%s\"", setting);
 		goto error;
@@ -860,6 +1010,7 @@ parse_wallpaper_config(char **saveptr, char **errstr) {
 error:
 	if(cfg) {
 		free(cfg->image_path);
+		free(cfg->slideshow);
 		free(cfg);
 	}
 	return NULL;
@@ -920,6 +1071,25 @@ parse_command(struct nedm_server *server, struct keybinding *keybinding,
 		keybinding->action = KEYBINDING_QUIT;
 	} else if(strcmp(action, "dump") == 0) {
 		keybinding->action = KEYBINDING_DUMP;
+	} else if(strcmp(action, "get") == 0) {
+		keybinding->action = KEYBINDING_GET;
+		if(parse_get(keybinding->data.us, &saveptr, errstr) != 0) {
+			return -1;
+		}
+	} else if(strcmp(action, "frame_stats") == 0) {
+		keybinding->action = KEYBINDING_FRAME_STATS;
+		keybinding->data.b = false;
+		char *reset_str = strtok_r(NULL, " ", &saveptr);
+		if(reset_str != NULL) {
+			if(strcmp(reset_str, "reset") != 0) {
+				*errstr = log_error(
+				    "Invalid option \"%s\" for \"frame_stats\". Expected "
+				    "\"reset\" or nothing.",
+				    reset_str);
+				return -1;
+			}
+			keybinding->data.b = true;
+		}
 	} else if(strcmp(action, "show_info") == 0) {
 		keybinding->action = KEYBINDING_SHOW_INFO;
 	} else if(strcmp(action, "close") == 0) {
@@ -1689,6 +1859,48 @@ parse_command(struct nedm_server *server, struct keybinding *keybinding,
 			return -1;
 		}
 		keybinding->data.u = (unsigned int)mode_idx;
+	} else if(strcmp(action, "subscribe") == 0) {
+		keybinding->action = KEYBINDING_SUBSCRIBE;
+		keybinding->data.mask = 0;
+		char *event_name = strtok_r(NULL, " ", &saveptr);
+		if(event_name == NULL) {
+			*errstr = log_error("Expected \"all\", \"none\" or a list of "
+			                    "events after \"subscribe\". Got nothing.");
+			return -1;
+		}
+		for(; event_name != NULL; event_name = strtok_r(NULL, " ", &saveptr)) {
+			if(strcmp(event_name, "all") == 0) {
+				keybinding->data.mask = NEDM_IPC_EVENT_MASK_ALL;
+			} else if(strcmp(event_name, "none") != 0) {
+				int event = ipc_event_from_str(event_name);
+				if(event < 0) {
+					*errstr = log_error(
+					    "Unknown event \"%s\" for \"subscribe\"", event_name);
+					return -1;
+				}
+				keybinding->data.mask |= NEDM_IPC_EVENT_MASK(event);
+			}
+		}
+	} else if(strcmp(action, "ipc_policy") == 0) {
+		keybinding->action = KEYBINDING_IPC_POLICY;
+		char *policy = strtok_r(NULL, " ", &saveptr);
+		if(policy == NULL) {
+			*errstr = log_error("Expected \"disconnect\", \"drop_oldest\" or "
+			                    "\"coalesce\" after \"ipc_policy\". Got "
+			                    "nothing.");
+			return -1;
+		}
+		if(strcmp(policy, "disconnect") == 0) {
+			keybinding->data.u = NEDM_IPC_POLICY_DISCONNECT;
+		} else if(strcmp(policy, "drop_oldest") == 0) {
+			keybinding->data.u = NEDM_IPC_POLICY_DROP_OLDEST;
+		} else if(strcmp(policy, "coalesce") == 0) {
+			keybinding->data.u = NEDM_IPC_POLICY_COALESCE;
+		} else {
+			*errstr =
+			    log_error("Unknown policy \"%s\" for \"ipc_policy\"", policy);
+			return -1;
+		}
 	} else if(strcmp(action, "setmodecursor") == 0) {
 		keybinding->action = KEYBINDING_SETMODECURSOR;
 		char *mode = strtok_r(NULL, " ", &saveptr);
@@ -1736,6 +1948,13 @@ parse_command(struct nedm_server *server, struct keybinding *keybinding,
 		if(keybinding->data.i < 0) {
 			return -1;
 		}
+	} else if(strcmp(action, "cursor_coalesce") == 0) {
+		keybinding->action = KEYBINDING_CURSOR_COALESCE;
+		int enable = parse_cursor_coalesce(&saveptr, errstr);
+		if(enable < 0) {
+			return -1;
+		}
+		keybinding->data.b = enable;
 	} else if(strcmp(action, "definemode") == 0) {
 		keybinding->action = KEYBINDING_DEFINEMODE;
 		keybinding->data.c = parse_definemode(&saveptr, errstr);
@@ -1779,8 +1998,11 @@ parse_command(struct nedm_server *server, struct keybinding *keybinding,
 	return 0;
 }
 
+/* Parses and runs a command. If status is not NULL, it is set to the value
+ * returned by the action. */
 int
-parse_rc_line(struct nedm_server *server, char *line, char **errstr) {
+parse_rc_line(struct nedm_server *server, char *line, char **errstr,
+              int *status) {
 	char *saveptr = strdup(line); // Used internally by strtok_r
 
 	struct keybinding *keybinding = malloc(sizeof(struct keybinding));
@@ -1797,7 +2019,10 @@ parse_rc_line(struct nedm_server *server, char *line, char **errstr) {
 		free(saveptr);
 		return -1;
 	}
-	run_action(keybinding->action, server, keybinding->data);
+	int ret = run_action(keybinding->action, server, keybinding->data);
+	if(status != NULL) {
+		*status = ret;
+	}
 	keybinding_free(keybinding, false);
 	free(saveptr);
 	return 0;
@@ -10,7 +10,8 @@
 struct nedm_server;
 
 int
-parse_rc_line(struct nedm_server *server, char *line, char **errstr);
+parse_rc_line(struct nedm_server *server, char *line, char **errstr,
+              int *status);
 char *
 parse_malloc_vsprintf(const char *fmt, ...);
 char *
@@ -42,6 +42,8 @@
 
 static void
 drag_icon_update_position(struct nedm_drag_icon *drag_icon);
+static void
+process_cursor_motion(struct nedm_seat *seat, uint32_t time);
 
 static void
 update_capabilities(const struct nedm_seat *seat) {
@@ -662,11 +664,31 @@ handle_touch_motion(struct wl_listener *listener, void *data) {
 	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
 }
 
+static void
+handle_motion_idle(void *data) {
+	struct nedm_seat *seat = data;
+	seat->motion_idle = NULL;
+	if(seat->motion_pending) {
+		seat->motion_pending = false;
+		/* Motion has already been sent to the client */
+		process_cursor_motion(seat, 0);
+	}
+}
+
 static void
 handle_cursor_frame(struct wl_listener *listener,
                     __attribute__((unused)) void *_data) {
 	struct nedm_seat *seat = wl_container_of(listener, seat, cursor_frame);
 
+	/* Backends emit a frame after every motion event, so the deferred work is
+	 * run once all events which are currently queued have been dispatched. */
+	if(seat->motion_pending && seat->motion_idle == NULL) {
+		seat->motion_idle = wl_event_loop_add_idle(seat->server->event_loop,
+		                                           handle_motion_idle, seat);
+		if(seat->motion_idle == NULL) {
+			handle_motion_idle(seat);
+		}
+	}
 	wlr_seat_pointer_notify_frame(seat->seat);
 	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
 }
@@ -687,21 +709,126 @@ handle_cursor_button(struct wl_listener *listener, void *data) {
 	struct nedm_seat *seat = wl_container_of(listener, seat, cursor_button);
 	struct wlr_pointer_button_event *event = data;
 
+	/* Make sure the button press goes to the surface under the cursor */
+	if(seat->motion_pending) {
+		seat->motion_pending = false;
+		process_cursor_motion(seat, 0);
+	}
 	wlr_seat_pointer_notify_button(seat->seat, event->time_msec, event->button,
 	                               event->state);
 	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
 }
 
 static void
-process_cursor_motion(struct nedm_seat *seat, uint32_t time) {
-	double sx, sy;
-	struct wlr_seat *wlr_seat = seat->seat;
-	struct wlr_surface *surface = NULL;
+hit_cache_clear(struct nedm_seat *seat) {
+	if(seat->hit_node != NULL) {
+		wl_list_remove(&seat->hit_node_destroy.link);
+		seat->hit_node = NULL;
+		seat->hit_surface = NULL;
+	}
+}
 
-	struct wlr_scene_node *node =
-	    wlr_scene_node_at(&seat->server->scene->tree.node, seat->cursor->x,
-	                      seat->cursor->y, &sx, &sy);
+static void
+handle_hit_node_destroy(struct wl_listener *listener,
+                        __attribute__((unused)) void *_data) {
+	struct nedm_seat *seat = wl_container_of(listener, seat, hit_node_destroy);
+	hit_cache_clear(seat);
+}
 
+/* Size of a rect or buffer node in layout coordinates */
+static void
+hit_node_size(struct wlr_scene_node *node, int *width, int *height) {
+	*width = 0;
+	*height = 0;
+	if(node->type == WLR_SCENE_NODE_RECT) {
+		struct wlr_scene_rect *rect = wlr_scene_rect_from_node(node);
+		*width = rect->width;
+		*height = rect->height;
+	} else if(node->type == WLR_SCENE_NODE_BUFFER) {
+		struct wlr_scene_buffer *buffer = wlr_scene_buffer_from_node(node);
+		if(buffer->dst_width > 0 && buffer->dst_height > 0) {
+			*width = buffer->dst_width;
+			*height = buffer->dst_height;
+		} else if(buffer->buffer != NULL) {
+			bool rotated = buffer->transform & WL_OUTPUT_TRANSFORM_90;
+			*width = rotated ? buffer->buffer->height : buffer->buffer->width;
+			*height = rotated ? buffer->buffer->width : buffer->buffer->height;
+		}
+	}
+}
+
+/* Whether a node of the subtree overlaps box. lx and ly are the layout
+ * coordinates of the parent of node. */
+static bool
+hit_subtree_overlaps(struct wlr_scene_node *node, int lx, int ly,
+                     const struct wlr_box *box) {
+	if(!node->enabled) {
+		return false;
+	}
+	lx += node->x;
+	ly += node->y;
+	if(node->type == WLR_SCENE_NODE_TREE) {
+		struct wlr_scene_tree *tree = wlr_scene_tree_from_node(node);
+		struct wlr_scene_node *child;
+		wl_list_for_each(child, &tree->children, link) {
+			if(hit_subtree_overlaps(child, lx, ly, box)) {
+				return true;
+			}
+		}
+		return false;
+	}
+	struct wlr_box node_box = {.x = lx, .y = ly};
+	hit_node_size(node, &node_box.width, &node_box.height);
+	struct wlr_box intersection;
+	return wlr_box_intersection(&intersection, &node_box, box);
+}
+
+/* Whether a node stacked above the hit node overlaps box, the layout box of
+ * the hit node. Only the siblings above the hit node and above each of its
+ * ancestors can be stacked above it, the rest of the scene is not visited. */
+static bool
+hit_occluded(struct wlr_scene_node *hit, const struct wlr_box *box) {
+	int lx = box->x, ly = box->y;
+	for(struct wlr_scene_node *node = hit; node->parent != NULL;
+	    node = &node->parent->node) {
+		// Layout coordinates of the parent
+		lx -= node->x;
+		ly -= node->y;
+		struct wl_list *children = &node->parent->children;
+		for(struct wl_list *link = node->link.next; link != children;
+		    link = link->next) {
+			struct wlr_scene_node *sibling =
+			    wl_container_of(link, sibling, link);
+			if(hit_subtree_overlaps(sibling, lx, ly, box)) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/* Returns the surface under the cursor (or NULL) and stores the surface local
+ * coordinates in sx and sy. */
+static struct wlr_surface *
+surface_at_cursor(struct nedm_seat *seat, double *sx, double *sy) {
+	double lx = seat->cursor->x, ly = seat->cursor->y;
+	if(seat->hit_node != NULL &&
+	   seat->hit_generation == seat->server->scene_generation &&
+	   wlr_box_contains_point(&seat->hit_box, lx, ly)) {
+		double nx = lx - seat->hit_box.x, ny = ly - seat->hit_box.y;
+		if(wlr_surface_point_accepts_input(seat->hit_surface, nx, ny)) {
+			++seat->hit_cache_hits;
+			*sx = nx;
+			*sy = ny;
+			return seat->hit_surface;
+		}
+	}
+	++seat->hit_cache_misses;
+	hit_cache_clear(seat);
+
+	struct wlr_surface *surface = NULL;
+	struct wlr_scene_node *node =
+	    wlr_scene_node_at(&seat->server->scene->tree.node, lx, ly, sx, sy);
 	if(node && node->type == WLR_SCENE_NODE_BUFFER) {
 		struct wlr_scene_surface *scene_surface =
 		    wlr_scene_surface_try_from_buffer(wlr_scene_buffer_from_node(node));
@@ -709,6 +836,35 @@ process_cursor_motion(struct nedm_seat *seat, uint32_t time) {
 			surface = scene_surface->surface;
 		}
 	}
+	struct wlr_box box = {0};
+	bool cacheable =
+	    surface != NULL && wlr_scene_node_coords(node, &box.x, &box.y);
+	if(cacheable) {
+		hit_node_size(node, &box.width, &box.height);
+		/* Points covered by a node above the surface, such as a popup, are
+		 * not answered from the cache */
+		cacheable = !hit_occluded(node, &box);
+	}
+	if(cacheable) {
+		seat->hit_node = node;
+		seat->hit_surface = surface;
+		seat->hit_box = box;
+		seat->hit_generation = seat->server->scene_generation;
+		seat->hit_node_destroy.notify = handle_hit_node_destroy;
+		wl_signal_add(&node->events.destroy, &seat->hit_node_destroy);
+	}
+	return surface;
+}
+
+static void
+process_cursor_motion(struct nedm_seat *seat, uint32_t time) {
+	double sx = 0, sy = 0;
+	struct wlr_seat *wlr_seat = seat->seat;
+
+	++seat->motion_processed;
+	struct wlr_surface *surface = surface_at_cursor(seat, &sx, &sy);
+	seat->pointer_surface_lx = seat->cursor->x - sx;
+	seat->pointer_surface_ly = seat->cursor->y - sy;
 
 	// Check for active pointer constraint
 	if (seat->active_constraint) {
@@ -760,34 +916,22 @@ skip_cursor_update:
 	/* Check if cursor switched tile */
 	struct wlr_output *c_outp = wlr_output_layout_output_at(
 	    seat->server->output_layout, seat->cursor->x, seat->cursor->y);
-	struct nedm_output *nedm_outp = NULL;
-	wl_list_for_each(nedm_outp, &seat->server->outputs, link) {
-		if(nedm_outp->wlr_output == c_outp) {
-			break;
-		}
-	}
-	if(c_outp) {
-		struct nedm_tile *c_tile;
-		bool first = true;
-		for(c_tile = nedm_outp->workspaces[nedm_outp->curr_workspace]->focused_tile;
-		    first ||
-		    c_tile !=
-		        nedm_outp->workspaces[nedm_outp->curr_workspace]->focused_tile;
-		    c_tile = c_tile->next) {
-			first = false;
-			double ox = seat->cursor->x, oy = seat->cursor->y;
-			wlr_output_layout_output_coords(seat->server->output_layout, c_outp,
-			                                &ox, &oy);
-			if(c_tile->tile.x <= ox && c_tile->tile.y <= oy &&
-			   c_tile->tile.x + c_tile->tile.width >= ox &&
-			   c_tile->tile.y + c_tile->tile.height >= oy) {
-				break;
-			}
+	if(c_outp && c_outp->data) {
+		struct nedm_output *nedm_outp = c_outp->data;
+		struct nedm_workspace *ws =
+		    nedm_outp->workspaces[nedm_outp->curr_workspace];
+		double ox = seat->cursor->x, oy = seat->cursor->y;
+		wlr_output_layout_output_coords(seat->server->output_layout, c_outp,
+		                                &ox, &oy);
+		struct nedm_tile *c_tile = workspace_tile_at(ws, ox, oy);
+		if(c_tile == NULL) {
+			c_tile = ws->focused_tile;
 		}
 		if(seat->cursor_tile != NULL && seat->cursor_tile != c_tile &&
 		   seat->server->running) {
-			ipc_send_event(
-			    seat->server,
+			ipc_send_state_event(
+			    seat->server, NEDM_IPC_EVENT_CURSOR_SWITCH_TILE,
+			    c_outp->name,
 			    "{\"event_name\":\"cursor_switch_tile\",\"old_output\":"
 			    "\"%s\",\"old_output_id\":%d,"
 			    "\"old_tile\":%d,\"new_output\":\"%s\",\"new_output_"
@@ -801,6 +945,19 @@ skip_cursor_update:
 	}
 }
 
+/* Send motion to the surface which currently has pointer focus and defer
+ * the remaining work of process_cursor_motion to the next frame */
+static void
+forward_cursor_motion(struct nedm_seat *seat, uint32_t time) {
+	struct wlr_seat *wlr_seat = seat->seat;
+	if(wlr_seat->pointer_state.focused_surface != NULL) {
+		wlr_seat_pointer_notify_motion(
+		    wlr_seat, time, seat->cursor->x - seat->pointer_surface_lx,
+		    seat->cursor->y - seat->pointer_surface_ly);
+	}
+	seat->motion_pending = true;
+}
+
 static void
 handle_cursor_motion_absolute(struct wl_listener *listener, void *data) {
 	struct nedm_seat *seat =
@@ -809,7 +966,12 @@ handle_cursor_motion_absolute(struct wl_listener *listener, void *data) {
 
 	wlr_cursor_warp_absolute(seat->cursor, &event->pointer->base, event->x,
 	                         event->y);
-	process_cursor_motion(seat, event->time_msec);
+	++seat->motion_events;
+	if(seat->coalesce_motion) {
+		forward_cursor_motion(seat, event->time_msec);
+	} else {
+		process_cursor_motion(seat, event->time_msec);
+	}
 	wlr_idle_notifier_v1_notify_activity(seat->server->idle, seat->seat);
 }
 
@@ -820,7 +982,12 @@ handle_cursor_motion(struct wl_listener *listener, void *data) {
 
 	wlr_cursor_move(seat->cursor, &event->pointer->base, event->delta_x,
 	                event->delta_y);
-	process_cursor_motion(seat, event->time_msec);
+	++seat->motion_events;
+	if(seat->coalesce_motion) {
+		forward_cursor_motion(seat, event->time_msec);
+	} else {
+		process_cursor_motion(seat, event->time_msec);
+	}
 
 	// Send relative motion AFTER cursor position is updated
 	if (seat->server->relative_pointer_manager) {
@@ -857,6 +1024,7 @@ drag_icon_update_position(struct nedm_drag_icon *drag_icon) {
 	}
 	wlr_scene_node_set_position(&drag_icon->scene_tree->node, drag_icon->lx,
 	                            drag_icon->ly);
+	++seat->server->scene_generation;
 }
 
 static void
@@ -1055,6 +1223,15 @@ seat_create(struct nedm_server *server) {
 	seat->mode = 0;
 	seat->default_mode = 0;
 	seat->active_constraint = NULL;
+	seat->coalesce_motion = false;
+	seat->motion_pending = false;
+	seat->motion_idle = NULL;
+	seat->motion_events = 0;
+	seat->motion_processed = 0;
+	seat->hit_node = NULL;
+	seat->hit_surface = NULL;
+	seat->hit_cache_hits = 0;
+	seat->hit_cache_misses = 0;
 
 	return seat;
 }
@@ -1075,6 +1252,12 @@ seat_destroy(struct nedm_seat *seat) {
 	wl_list_remove(&seat->request_start_drag.link);
 	wl_list_remove(&seat->start_drag.link);
 
+	if(seat->motion_idle != NULL) {
+		wl_event_source_remove(seat->motion_idle);
+		seat->motion_idle = NULL;
+	}
+	hit_cache_clear(seat);
+
 	// Destroying the wlr seat will trigger the destroy handler on our seat,
 	// which will in turn free it.
 	wlr_seat_destroy(seat->seat);
@@ -1167,3 +1350,12 @@ seat_set_focus(struct nedm_seat *seat, struct nedm_view *view) {
 	    output_get_layout_box(view->workspace->output).x,
 	    output_get_layout_box(view->workspace->output).y);
 }
+
+void
+seat_set_coalesce_motion(struct nedm_seat *seat, bool enabled) {
+	seat->coalesce_motion = enabled;
+	if(!enabled && seat->motion_pending) {
+		seat->motion_pending = false;
+		process_cursor_motion(seat, 0);
+	}
+}
@@ -5,6 +5,7 @@
 #define NEDM_SEAT_H
 
 #include <wayland-server-core.h>
+#include <wlr/util/box.h>
 
 struct nedm_server;
 struct nedm_view;
@@ -43,6 +44,29 @@ struct nedm_seat {
 	struct wl_listener cursor_axis;
 	struct wl_listener cursor_frame;
 
+	/* If coalesce_motion is set, pointer motion is forwarded to the focused
+	 * surface immediately, while the hit test, tile tracking and ipc events
+	 * are only done once per batch of events (see handle_cursor_frame). */
+	bool coalesce_motion;
+	bool motion_pending;
+	struct wl_event_source *motion_idle;
+	/* Layout coordinates of the origin of the surface found by the last hit
+	 * test */
+	double pointer_surface_lx, pointer_surface_ly;
+	uint64_t motion_events;
+	uint64_t motion_processed;
+
+	/* Cache of the surface found by the last hit test, valid as long as
+	 * hit_generation equals server->scene_generation and the cursor stays
+	 * within hit_box. Only surfaces which no other node covers are cached. */
+	struct wlr_scene_node *hit_node;
+	struct wlr_surface *hit_surface;
+	struct wlr_box hit_box; // Layout coordinates of hit_node
+	uint32_t hit_generation;
+	struct wl_listener hit_node_destroy;
+	uint64_t hit_cache_hits;
+	uint64_t hit_cache_misses;
+
 	int32_t touch_id;
 	double touch_lx;
 	double touch_ly;
@@ -116,4 +140,6 @@ void
 seat_add_device(struct nedm_seat *seat, struct nedm_input_device *device);
 void
 seat_remove_device(struct nedm_seat *seat, struct nedm_input_device *device);
+void
+seat_set_coalesce_motion(struct nedm_seat *seat, bool enabled);
 #endif
@@ -20,6 +20,9 @@ struct wlr_idle_inhibit_manager_v1;
 struct nedm_output_config;
 struct nedm_input_manager;
 struct nedm_layer_shell;
+struct nedm_transaction;
+struct nedm_worker;
+struct wlr_content_type_manager_v1;
 
 struct nedm_server {
 	struct wl_display *wl_display;
@@ -57,6 +60,7 @@ struct nedm_server {
 	struct wl_list layer_surfaces;
 	struct wlr_pointer_constraints_v1 *pointer_constraints;
 	struct wlr_relative_pointer_manager_v1 *relative_pointer_manager;
+	struct wlr_content_type_manager_v1 *content_type_manager;
 	struct wl_listener new_pointer_constraint;
 #if NEDM_HAS_XWAYLAND
 	struct wl_listener new_xwayland_surface;
@@ -67,9 +71,16 @@ struct nedm_server {
 	struct wl_list output_config;
 	struct wl_list input_config;
 	struct nedm_message_config message_config;
+	struct nedm_message_cache message_cache;
 	struct nedm_wallpaper_config wallpaper_config;
+	struct wl_list wallpapers;        // nedm_wallpaper::link
+	struct wl_list wallpaper_images;  // nedm_wallpaper_image::link
+	struct wl_list wallpaper_renders; // nedm_wallpaper_render::link
+	struct nedm_wallpaper_slideshow wallpaper_slideshow;
 
 	struct nedm_ipc_handle ipc;
+	struct nedm_transaction *transaction;
+	struct nedm_worker *worker;
 
 	bool enable_socket;
 	bool bs;
@@ -81,6 +92,9 @@ struct nedm_server {
 	uint32_t views_curr_id;
 	uint32_t tiles_curr_id;
 	uint32_t xcursor_size;
+	/* Incremented whenever the stacking or the position of nodes in the scene
+	 * changes, used to invalidate the cursor hit test cache */
+	uint32_t scene_generation;
 };
 
 void
@@ -0,0 +1,190 @@
+// Copyright 2020 - 2025, project-repo and the NEDM contributors
+// SPDX-License-Identifier: MIT
+
+#include <stdlib.h>
+#include <wayland-server-core.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/types/wlr_scene.h>
+#include <wlr/util/log.h>
+
+#include "output.h"
+#include "server.h"
+#include "transaction.h"
+#include "view.h"
+#include "workspace.h"
+
+static void
+transaction_apply(struct nedm_transaction *transaction) {
+	struct nedm_server *server = transaction->server;
+	struct nedm_view *view, *tmp;
+	wl_list_for_each_safe(view, tmp, &transaction->views, transaction_link) {
+		wlr_scene_node_set_position(&view->scene_tree->node,
+		                            view->transaction_lx, view->transaction_ly);
+		view->transaction_serial = 0;
+		wl_list_remove(&view->transaction_link);
+		wl_list_init(&view->transaction_link);
+	}
+	transaction->npending = 0;
+	transaction->committed = false;
+	wl_event_source_timer_update(transaction->timer, 0);
+	++server->scene_generation;
+
+	/* Frames may have been skipped while the transaction was pending */
+	struct nedm_output *output;
+	wl_list_for_each(output, &server->outputs, link) {
+		if(!output->destroyed && output->wlr_output->enabled) {
+			wlr_output_schedule_frame(output->wlr_output);
+		}
+	}
+}
+
+static int
+handle_transaction_timeout(void *data) {
+	struct nedm_transaction *transaction = data;
+	wlr_log(WLR_DEBUG,
+	        "Transaction timed out with %u views not having acked their "
+	        "configure",
+	        transaction->npending);
+	transaction_apply(transaction);
+	return 0;
+}
+
+static void
+handle_transaction_commit(void *data) {
+	struct nedm_transaction *transaction = data;
+	transaction->idle = NULL;
+	if(transaction->npending == 0) {
+		transaction_apply(transaction);
+		return;
+	}
+	if(!transaction->committed) {
+		transaction->committed = true;
+		wl_event_source_timer_update(transaction->timer,
+		                             NEDM_TRANSACTION_TIMEOUT);
+	}
+}
+
+static void
+transaction_schedule_commit(struct nedm_transaction *transaction) {
+	if(transaction->idle != NULL) {
+		return;
+	}
+	transaction->idle = wl_event_loop_add_idle(
+	    transaction->server->event_loop, handle_transaction_commit, transaction);
+	if(transaction->idle == NULL) {
+		transaction_apply(transaction);
+	}
+}
+
+/* Record the new layout position of a view. If serial is not 0, the position
+ * is only applied after the client has acked the configure with that serial.
+ */
+void
+transaction_add_view(struct nedm_view *view, int lx, int ly, uint32_t serial) {
+	struct nedm_transaction *transaction = view->server->transaction;
+	if(transaction == NULL || !view->server->running) {
+		wlr_scene_node_set_position(&view->scene_tree->node, lx, ly);
+		return;
+	}
+	view->transaction_lx = lx;
+	view->transaction_ly = ly;
+	if(wl_list_empty(&view->transaction_link)) {
+		wl_list_insert(transaction->views.prev, &view->transaction_link);
+	} else if(view->transaction_serial != 0) {
+		--transaction->npending;
+	}
+	view->transaction_serial = serial;
+	if(serial != 0) {
+		++transaction->npending;
+	}
+	transaction_schedule_commit(transaction);
+}
+
+void
+transaction_remove_view(struct nedm_view *view) {
+	struct nedm_transaction *transaction = view->server->transaction;
+	if(transaction == NULL || wl_list_empty(&view->transaction_link)) {
+		return;
+	}
+	if(view->transaction_serial != 0) {
+		--transaction->npending;
+		view->transaction_serial = 0;
+	}
+	wl_list_remove(&view->transaction_link);
+	wl_list_init(&view->transaction_link);
+	if(transaction->committed && transaction->npending == 0) {
+		transaction_apply(transaction);
+	}
+}
+
+/* Called whenever a view commits with the given configure serial */
+void
+transaction_view_ack(struct nedm_view *view, uint32_t serial) {
+	struct nedm_transaction *transaction = view->server->transaction;
+	if(transaction == NULL || view->transaction_serial == 0 ||
+	   (int32_t)(serial - view->transaction_serial) < 0) {
+		return;
+	}
+	view->transaction_serial = 0;
+	--transaction->npending;
+	if(transaction->committed && transaction->npending == 0) {
+		transaction_apply(transaction);
+	}
+}
+
+/* Returns whether the output shows views which are part of the pending
+ * transaction, in which case the output should not commit a new frame */
+bool
+transaction_output_blocked(const struct nedm_output *output) {
+	struct nedm_transaction *transaction = output->server->transaction;
+	if(transaction == NULL || transaction->npending == 0) {
+		return false;
+	}
+	struct nedm_view *view;
+	wl_list_for_each(view, &transaction->views, transaction_link) {
+		if(view->workspace != NULL && view->workspace->output == output) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int
+transaction_init(struct nedm_server *server) {
+	struct nedm_transaction *transaction =
+	    calloc(1, sizeof(struct nedm_transaction));
+	if(transaction == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate transaction");
+		return -1;
+	}
+	transaction->server = server;
+	wl_list_init(&transaction->views);
+	transaction->timer = wl_event_loop_add_timer(
+	    server->event_loop, handle_transaction_timeout, transaction);
+	if(transaction->timer == NULL) {
+		wlr_log(WLR_ERROR, "Failed to create transaction timer");
+		free(transaction);
+		return -1;
+	}
+	server->transaction = transaction;
+	return 0;
+}
+
+void
+transaction_finish(struct nedm_server *server) {
+	struct nedm_transaction *transaction = server->transaction;
+	if(transaction == NULL) {
+		return;
+	}
+	struct nedm_view *view, *tmp;
+	wl_list_for_each_safe(view, tmp, &transaction->views, transaction_link) {
+		wl_list_remove(&view->transaction_link);
+		wl_list_init(&view->transaction_link);
+	}
+	if(transaction->idle != NULL) {
+		wl_event_source_remove(transaction->idle);
+	}
+	wl_event_source_remove(transaction->timer);
+	server->transaction = NULL;
+	free(transaction);
+}
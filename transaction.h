@@ -0,0 +1,46 @@
+// Copyright 2020 - 2025, project-repo and the NEDM contributors
+// SPDX-License-Identifier: MIT
+
+#ifndef NEDM_TRANSACTION_H
+#define NEDM_TRANSACTION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wayland-server-core.h>
+
+/* Time in milliseconds to wait for clients to acknowledge their configure
+ * events before a transaction is applied anyway */
+#define NEDM_TRANSACTION_TIMEOUT 200
+
+struct nedm_server;
+struct nedm_output;
+struct nedm_view;
+
+/* Layout changes (i.e. calls to view_maximize) are collected in a transaction
+ * which is committed once the current batch of events has been processed. The
+ * new positions of all views are applied at once as soon as every client has
+ * acknowledged its configure event (or the timeout expires). Until then,
+ * outputs showing affected views do not commit new frames. */
+struct nedm_transaction {
+	struct nedm_server *server;
+	struct wl_list views; // nedm_view::transaction_link
+	uint32_t npending;    // Number of views which have not acked yet
+	bool committed;
+	struct wl_event_source *idle;
+	struct wl_event_source *timer;
+};
+
+int
+transaction_init(struct nedm_server *server);
+void
+transaction_finish(struct nedm_server *server);
+void
+transaction_add_view(struct nedm_view *view, int lx, int ly, uint32_t serial);
+void
+transaction_remove_view(struct nedm_view *view);
+void
+transaction_view_ack(struct nedm_view *view, uint32_t serial);
+bool
+transaction_output_blocked(const struct nedm_output *output);
+
+#endif
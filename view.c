@@ -16,6 +16,7 @@
 #include "output.h"
 #include "seat.h"
 #include "server.h"
+#include "transaction.h"
 #include "view.h"
 #include "workspace.h"
 #if NEDM_HAS_XWAYLAND
@@ -78,13 +79,14 @@ view_activate(struct nedm_view *view, bool activate) {
 
 void
 view_maximize(struct nedm_view *view, struct nedm_tile *tile) {
+	++view->server->scene_generation;
 	view->ox = tile->tile.x;
 	view->oy = tile->tile.y;
-	wlr_scene_node_set_position(
-	    &view->scene_tree->node,
-	    view->ox + output_get_layout_box(view->workspace->output).x,
-	    view->oy + output_get_layout_box(view->workspace->output).y);
-	view->impl->maximize(view, tile->tile.width, tile->tile.height);
+	uint32_t serial =
+	    view->impl->maximize(view, tile->tile.width, tile->tile.height);
+	transaction_add_view(
+	    view, view->ox + output_get_layout_box(view->workspace->output).x,
+	    view->oy + output_get_layout_box(view->workspace->output).y, serial);
 	view->tile = tile;
 	wlr_scene_node_raise_to_top(&view->scene_tree->node);
 }
@@ -101,6 +103,7 @@ view_unmap(struct nedm_view *view) {
 	if(view->wlr_surface == NULL) {
 		return;
 	}
+	++view->server->scene_generation;
 
 	if(view->tile == NULL) {
 		tile_id = -1;
@@ -138,10 +141,11 @@ view_unmap(struct nedm_view *view) {
 #endif
 
 	wl_list_remove(&view->link);
+	transaction_remove_view(view);
 
 	view->wlr_surface = NULL;
 	ipc_send_event(
-	    view->workspace->server,
+	    view->workspace->server, NEDM_IPC_EVENT_VIEW_UNMAP,
 	    "{\"event_name\":\"view_unmap\",\"view_id\":%d,\"tile_id\":%d,"
 	    "\"workspace\":%d,\"output\":\"%s\",\"output_id\":%d,\"view_pid\":%d}",
 	    id, tile_id, ws + 1, output_name, output_id, pid);
@@ -152,6 +156,7 @@ view_map(struct nedm_view *view, struct wlr_surface *surface,
          struct nedm_workspace *ws) {
 	struct nedm_output *output = ws->output;
 	view->wlr_surface = surface;
+	++output->server->scene_generation;
 
 	wlr_scene_node_reparent(&view->scene_tree->node, ws->scene);
 	if(!view->scene_tree) {
@@ -183,7 +188,7 @@ view_map(struct nedm_view *view, struct wlr_surface *surface,
 		tile_id = view->tile->id;
 	}
 	ipc_send_event(
-	    output->server,
+	    output->server, NEDM_IPC_EVENT_VIEW_MAP,
 	    "{\"event_name\":\"view_map\",\"view_id\":%d,\"tile_id\":%d,"
 	    "\"workspace\":%d,\"output\":\"%s\",\"output_id\":%d,\"view_pid\":%d}",
 	    view->id, tile_id, view->workspace->num + 1,
@@ -198,6 +203,7 @@ view_destroy(struct nedm_view *view) {
 		view_unmap(view);
 	}
 
+	transaction_remove_view(view);
 	wlr_scene_node_destroy(&view->scene_tree->node);
 
 	view->impl->destroy(view);
@@ -216,6 +222,8 @@ view_init(struct nedm_view *view, enum nedm_view_type type,
 	view->impl = impl;
 	view->id = server->views_curr_id;
 	++server->views_curr_id;
+	wl_list_init(&view->transaction_link);
+	view->transaction_serial = 0;
 	view->scene_tree = wlr_scene_tree_create(
 	    server->curr_output->workspaces[server->curr_output->curr_workspace]
 	        ->scene);
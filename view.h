@@ -35,6 +35,11 @@ struct nedm_view {
 	/* The view has a position in output coordinates. */
 	int ox, oy;
 
+	/* Pending layout position, see transaction.h */
+	struct wl_list transaction_link; // nedm_transaction::views
+	int transaction_lx, transaction_ly;
+	uint32_t transaction_serial; // 0 if no configure ack is awaited
+
 	enum nedm_view_type type;
 	const struct nedm_view_impl *impl;
 
@@ -47,7 +52,8 @@ struct nedm_view_impl {
 	bool (*is_primary)(const struct nedm_view *view);
 	void (*activate)(struct nedm_view *view, bool activate);
 	void (*close)(struct nedm_view *view);
-	void (*maximize)(struct nedm_view *view, int width, int height);
+	/* Returns the serial of the configure event the view has to ack or 0 */
+	uint32_t (*maximize)(struct nedm_view *view, int width, int height);
 	void (*destroy)(struct nedm_view *view);
 };
 
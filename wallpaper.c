@@ -5,9 +5,14 @@
 #include "output.h"
 #include "server.h"
 #include "util.h"
+#include "worker.h"
 
+#include <wlr/render/pixman.h>
+#include <wlr/render/wlr_renderer.h>
+#include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_scene.h>
+#include <wlr/util/box.h>
 #include <wlr/util/log.h>
 
 #include <cairo.h>
@@ -15,20 +20,24 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <dirent.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <wlr/interfaces/wlr_buffer.h>
 #include <drm_fourcc.h>
 
+/* A wlr_buffer backed by the pixels of a cairo image surface */
 struct wallpaper_buffer {
 	struct wlr_buffer base;
-	void *data;
+	cairo_surface_t *surface;
 	uint32_t format;
-	size_t stride;
 };
 
 static void
 wallpaper_buffer_destroy(struct wlr_buffer *wlr_buffer) {
 	struct wallpaper_buffer *buffer = wl_container_of(wlr_buffer, buffer, base);
-	free(buffer->data);
+	cairo_surface_destroy(buffer->surface);
 	free(buffer);
 }
 
@@ -39,13 +48,13 @@ wallpaper_buffer_begin_data_ptr_access(struct wlr_buffer *wlr_buffer,
                                  size_t *stride) {
 	struct wallpaper_buffer *buffer = wl_container_of(wlr_buffer, buffer, base);
 	if(data != NULL) {
-		*data = (void *)buffer->data;
+		*data = (void *)cairo_image_surface_get_data(buffer->surface);
 	}
 	if(format != NULL) {
 		*format = buffer->format;
 	}
 	if(stride != NULL) {
-		*stride = buffer->stride;
+		*stride = cairo_image_surface_get_stride(buffer->surface);
 	}
 	return true;
 }
@@ -62,278 +71,1040 @@ static const struct wlr_buffer_impl wallpaper_buffer_impl = {
     .end_data_ptr_access = wallpaper_buffer_end_data_ptr_access,
 };
 
-static struct wallpaper_buffer *
-wallpaper_buffer_create(uint32_t width, uint32_t height, uint32_t stride) {
+/* Wraps the image surface without copying its pixels. Takes over the
+ * reference to surface, even on failure. */
+static struct wlr_buffer *
+wallpaper_buffer_create(cairo_surface_t *surface) {
+	cairo_format_t format = cairo_image_surface_get_format(surface);
+	if(format != CAIRO_FORMAT_ARGB32 && format != CAIRO_FORMAT_RGB24) {
+		wlr_log(WLR_ERROR, "Unsupported pixel format of wallpaper image");
+		cairo_surface_destroy(surface);
+		return NULL;
+	}
 	struct wallpaper_buffer *buffer = calloc(1, sizeof(*buffer));
 	if(buffer == NULL) {
+		cairo_surface_destroy(surface);
 		return NULL;
 	}
-	size_t size = stride * height;
-	buffer->data = malloc(size);
-	if(buffer->data == NULL) {
-		free(buffer);
-		return NULL;
+	cairo_surface_flush(surface);
+	buffer->surface = surface;
+	buffer->format = format == CAIRO_FORMAT_RGB24 ? DRM_FORMAT_XRGB8888
+	                                              : DRM_FORMAT_ARGB8888;
+	wlr_buffer_init(&buffer->base, &wallpaper_buffer_impl,
+	                cairo_image_surface_get_width(surface),
+	                cairo_image_surface_get_height(surface));
+	return &buffer->base;
+}
+
+/* Uploads the buffer to the GPU. The returned buffer only references the
+ * texture, so that the pixels in system memory are freed. With the pixman
+ * renderer, the buffer is kept as is. Consumes buffer, the returned buffer has
+ * to be released with wlr_buffer_unlock. */
+static struct wlr_buffer *
+wallpaper_buffer_upload(struct wlr_renderer *renderer,
+                        struct wlr_buffer *buffer) {
+	if(!wlr_renderer_is_pixman(renderer)) {
+		struct wlr_client_buffer *client_buffer =
+		    wlr_client_buffer_create(buffer, renderer);
+		if(client_buffer != NULL) {
+			wlr_buffer_drop(buffer);
+			return &client_buffer->base;
+		}
+		wlr_log(WLR_ERROR, "Failed to upload wallpaper to the GPU, keeping "
+		                   "it in system memory");
 	}
-	buffer->format = DRM_FORMAT_XRGB8888;
-	buffer->stride = stride;
-	wlr_buffer_init(&buffer->base, &wallpaper_buffer_impl, width, height);
+	wlr_buffer_lock(buffer);
+	wlr_buffer_drop(buffer);
 	return buffer;
 }
 
-
-static void wallpaper_calculate_scaling(struct nedm_wallpaper *wallpaper, 
-		double *scale_x, double *scale_y, double *offset_x, double *offset_y) {
-	
-	double img_w = wallpaper->image_width;
-	double img_h = wallpaper->image_height;
-	double out_w = wallpaper->output_width;
-	double out_h = wallpaper->output_height;
-	
+static void
+wallpaper_calculate_scaling(enum nedm_wallpaper_mode mode, double img_w,
+                            double img_h, double out_w, double out_h,
+                            float output_scale, double *scale_x,
+                            double *scale_y, double *offset_x,
+                            double *offset_y) {
 	*scale_x = 1.0;
 	*scale_y = 1.0;
 	*offset_x = 0.0;
 	*offset_y = 0.0;
-	
-	switch (wallpaper->mode) {
-		case NEDM_WALLPAPER_FILL: {
-			// Scale to fill the entire output, cropping if necessary
-			double scale = fmax(out_w / img_w, out_h / img_h);
-			*scale_x = scale;
-			*scale_y = scale;
-			*offset_x = (out_w - img_w * scale) / 2.0;
-			*offset_y = (out_h - img_h * scale) / 2.0;
-			break;
-		}
-		case NEDM_WALLPAPER_FIT: {
-			// Scale to fit entirely within the output, maintaining aspect ratio
-			double scale = fmin(out_w / img_w, out_h / img_h);
-			*scale_x = scale;
-			*scale_y = scale;
-			*offset_x = (out_w - img_w * scale) / 2.0;
-			*offset_y = (out_h - img_h * scale) / 2.0;
-			break;
+
+	switch(mode) {
+	case NEDM_WALLPAPER_FILL: {
+		// Scale to fill the entire output, cropping if necessary
+		double scale = fmax(out_w / img_w, out_h / img_h);
+		*scale_x = scale;
+		*scale_y = scale;
+		*offset_x = (out_w - img_w * scale) / 2.0;
+		*offset_y = (out_h - img_h * scale) / 2.0;
+		break;
+	}
+	case NEDM_WALLPAPER_FIT: {
+		// Scale to fit entirely within the output, maintaining aspect ratio
+		double scale = fmin(out_w / img_w, out_h / img_h);
+		*scale_x = scale;
+		*scale_y = scale;
+		*offset_x = (out_w - img_w * scale) / 2.0;
+		*offset_y = (out_h - img_h * scale) / 2.0;
+		break;
+	}
+	case NEDM_WALLPAPER_STRETCH: {
+		// Stretch to fill the entire output, ignoring aspect ratio
+		*scale_x = out_w / img_w;
+		*scale_y = out_h / img_h;
+		*offset_x = 0.0;
+		*offset_y = 0.0;
+		break;
+	}
+	case NEDM_WALLPAPER_CENTER: {
+		// Center the image, one image pixel per output pixel
+		*scale_x = 1.0 / output_scale;
+		*scale_y = 1.0 / output_scale;
+		*offset_x = (out_w - img_w * *scale_x) / 2.0;
+		*offset_y = (out_h - img_h * *scale_y) / 2.0;
+		break;
+	}
+	case NEDM_WALLPAPER_TILE: {
+		// Tile the image (no scaling, repeat pattern)
+		*scale_x = 1.0 / output_scale;
+		*scale_y = 1.0 / output_scale;
+		*offset_x = 0.0;
+		*offset_y = 0.0;
+		break;
+	}
+	case NEDM_WALLPAPER_NOPT: // This should never occur
+		break;
+	}
+}
+
+/* Decodes an image on the worker */
+struct wallpaper_decode_job {
+	struct nedm_worker_job base;
+	struct nedm_server *server;
+	struct nedm_wallpaper_image *image; // Holds a reference
+	const char *path;                   // Owned by image
+	uint32_t width;
+	uint32_t height;
+	enum nedm_image_fit fit;
+	cairo_surface_t *surface;
+};
+
+/* Rasterizes a wallpaper for the CPU path on the worker */
+struct wallpaper_render_job {
+	struct nedm_worker_job base;
+	struct nedm_server *server;
+	struct nedm_wallpaper_render *render; // Holds a reference
+	cairo_surface_t *image;               // Holds a reference
+	cairo_surface_t *surface;
+};
+
+static bool
+timespec_equal(const struct timespec *a, const struct timespec *b) {
+	return a->tv_sec == b->tv_sec && a->tv_nsec == b->tv_nsec;
+}
+
+/* Whether the image can be shown by a wallpaper rendered on the CPU or GPU */
+static bool
+wallpaper_image_ready(const struct nedm_wallpaper_image *image, bool cpu) {
+	return cpu ? image->surface != NULL : image->buffer != NULL;
+}
+
+static void
+wallpaper_image_unref(struct nedm_wallpaper_image *image) {
+	if(image == NULL || --image->refcount > 0) {
+		return;
+	}
+	wl_list_remove(&image->link);
+	if(image->buffer != NULL) {
+		wlr_buffer_unlock(image->buffer);
+	}
+	if(image->surface != NULL) {
+		cairo_surface_destroy(image->surface);
+	}
+	free(image->path);
+	free(image);
+}
+
+/* Upload the image once, the renderer scales it */
+static void
+wallpaper_image_upload(struct nedm_server *server,
+                       struct nedm_wallpaper_image *image) {
+	struct wlr_buffer *buffer =
+	    wallpaper_buffer_create(cairo_surface_reference(image->surface));
+	if(buffer == NULL) {
+		image->failed = true;
+		return;
+	}
+	image->buffer = wallpaper_buffer_upload(server->renderer, buffer);
+	if(!image->cpu) {
+		cairo_surface_destroy(image->surface);
+		image->surface = NULL;
+	}
+}
+
+/* Update every wallpaper which shows or waits for image */
+static void
+wallpaper_image_notify(struct nedm_server *server,
+                       struct nedm_wallpaper_image *image) {
+	struct nedm_wallpaper *wallpaper, *tmp;
+	wl_list_for_each_safe(wallpaper, tmp, &server->wallpapers, link) {
+		if(wallpaper->image == image || wallpaper->pending_image == image) {
+			nedm_wallpaper_render(wallpaper);
 		}
-		case NEDM_WALLPAPER_STRETCH: {
-			// Stretch to fill the entire output, ignoring aspect ratio
-			*scale_x = out_w / img_w;
-			*scale_y = out_h / img_h;
-			*offset_x = 0.0;
-			*offset_y = 0.0;
-			break;
+	}
+}
+
+static void
+wallpaper_decode_run(struct nedm_worker_job *base) {
+	struct wallpaper_decode_job *job = wl_container_of(base, job, base);
+	job->surface = image_load(job->path, job->width, job->height, job->fit);
+}
+
+static void
+wallpaper_decode_done(struct nedm_worker_job *base, bool cancelled) {
+	struct wallpaper_decode_job *job = wl_container_of(base, job, base);
+	struct nedm_server *server = job->server;
+	struct nedm_wallpaper_image *image = job->image;
+	cairo_surface_t *surface = job->surface;
+	free(job);
+
+	image->decoding = false;
+	if(cancelled) {
+		cairo_surface_destroy(surface);
+		wallpaper_image_unref(image);
+		return;
+	}
+	if(surface == NULL) {
+		wlr_log(WLR_ERROR, "Failed to load wallpaper image: %s", image->path);
+		image->failed = true;
+	} else {
+		image->surface = surface;
+		image->width = cairo_image_surface_get_width(surface);
+		image->height = cairo_image_surface_get_height(surface);
+		image->opaque =
+		    cairo_image_surface_get_format(surface) == CAIRO_FORMAT_RGB24;
+		wlr_log(WLR_INFO, "Loaded wallpaper: %s (%dx%d)", image->path,
+		        image->width, image->height);
+		if(image->gpu && image->buffer == NULL) {
+			wallpaper_image_upload(server, image);
 		}
-		case NEDM_WALLPAPER_CENTER: {
-			// Center the image without scaling
-			*scale_x = 1.0;
-			*scale_y = 1.0;
-			*offset_x = (out_w - img_w) / 2.0;
-			*offset_y = (out_h - img_h) / 2.0;
+	}
+	wallpaper_image_notify(server, image);
+	wallpaper_image_unref(image);
+}
+
+static void
+wallpaper_image_decode(struct nedm_server *server,
+                       struct nedm_wallpaper_image *image) {
+	struct wallpaper_decode_job *job = calloc(1, sizeof(*job));
+	if(job == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate wallpaper decode job");
+		image->failed = true;
+		return;
+	}
+	job->base.run = wallpaper_decode_run;
+	job->base.done = wallpaper_decode_done;
+	job->server = server;
+	job->image = image;
+	job->path = image->path;
+	job->width = image->target_width;
+	job->height = image->target_height;
+	job->fit = image->fit;
+	++image->refcount;
+	image->decoding = true;
+	worker_submit(server, &job->base);
+}
+
+/* Returns a reference to the image at path, downsampled to width x height
+ * according to fit. Images are shared as long as the file did not change. If
+ * cpu is set, the decoded pixels are kept in system memory for rendering on
+ * the CPU, otherwise the image is uploaded to the GPU. The image is decoded on
+ * the worker, the wallpapers using it are rendered again once it is ready. */
+static struct nedm_wallpaper_image *
+wallpaper_image_get(struct nedm_server *server, const char *path, bool cpu,
+                    uint32_t width, uint32_t height, enum nedm_image_fit fit) {
+	struct stat st;
+	if(stat(path, &st) != 0) {
+		wlr_log(WLR_ERROR, "Failed to stat wallpaper image: %s", path);
+		return NULL;
+	}
+
+	struct nedm_wallpaper_image *image = NULL, *it;
+	wl_list_for_each(it, &server->wallpaper_images, link) {
+		if(strcmp(it->path, path) == 0 && it->size == st.st_size &&
+		   timespec_equal(&it->mtime, &st.st_mtim) && it->fit == fit &&
+		   it->target_width == width && it->target_height == height) {
+			image = it;
 			break;
 		}
-		case NEDM_WALLPAPER_TILE: {
-			// Tile the image (no scaling, repeat pattern)
-			*scale_x = 1.0;
-			*scale_y = 1.0;
-			*offset_x = 0.0;
-			*offset_y = 0.0;
-			break;
+	}
+
+	if(image == NULL) {
+		image = calloc(1, sizeof(*image));
+		if(image == NULL || (image->path = strdup(path)) == NULL) {
+			wlr_log(WLR_ERROR, "Failed to allocate wallpaper image");
+			free(image);
+			return NULL;
 		}
+		image->mtime = st.st_mtim;
+		image->size = st.st_size;
+		image->fit = fit;
+		image->target_width = width;
+		image->target_height = height;
+		wl_list_insert(&server->wallpaper_images, &image->link);
 	}
+	++image->refcount;
+	image->cpu |= cpu;
+	image->gpu |= !cpu;
+
+	if(image->decoding || image->failed) {
+		return image;
+	}
+	if(image->surface == NULL && (cpu || image->buffer == NULL)) {
+		/* Not decoded yet, or the pixels were freed after the upload */
+		wallpaper_image_decode(server, image);
+	} else if(!cpu && image->buffer == NULL) {
+		wallpaper_image_upload(server, image);
+	}
+	return image;
 }
 
-bool nedm_wallpaper_load_image(struct nedm_wallpaper *wallpaper, const char *path) {
-	if (!path) {
+/* Only the resolution of the output is decoded, as long as the image is
+ * scaled to it anyway */
+static enum nedm_image_fit
+wallpaper_image_fit(const struct nedm_wallpaper *wallpaper, uint32_t *width,
+                    uint32_t *height) {
+	*width = ceil(wallpaper->output_width * wallpaper->output_scale);
+	*height = ceil(wallpaper->output_height * wallpaper->output_scale);
+	switch(wallpaper->mode) {
+	case NEDM_WALLPAPER_FILL:
+	case NEDM_WALLPAPER_STRETCH:
+		return NEDM_IMAGE_FIT_COVER;
+	case NEDM_WALLPAPER_FIT:
+		return NEDM_IMAGE_FIT_CONTAIN;
+	default:
+		/* Centered and tiled images are shown at their native size */
+		*width = 0;
+		*height = 0;
+		return NEDM_IMAGE_FIT_NONE;
+	}
+}
+
+bool
+nedm_wallpaper_load_image(struct nedm_wallpaper *wallpaper, const char *path) {
+	if(!path) {
 		wlr_log(WLR_ERROR, "No wallpaper path provided");
 		return false;
 	}
-	
-	// Load the image using Cairo
-	wallpaper->image_surface = cairo_image_surface_create_from_png(path);
-	if (cairo_surface_status(wallpaper->image_surface) != CAIRO_STATUS_SUCCESS) {
-		wlr_log(WLR_ERROR, "Failed to load wallpaper image: %s", path);
-		if (wallpaper->image_surface) {
-			cairo_surface_destroy(wallpaper->image_surface);
-			wallpaper->image_surface = NULL;
-		}
+
+	uint32_t width, height;
+	enum nedm_image_fit fit = wallpaper_image_fit(wallpaper, &width, &height);
+	struct nedm_wallpaper_image *image =
+	    wallpaper_image_get(wallpaper->output->server, path,
+	                        wallpaper->cpu_render, width, height, fit);
+	if(!image) {
 		return false;
 	}
-	
-	// Get image dimensions
-	wallpaper->image_width = cairo_image_surface_get_width(wallpaper->image_surface);
-	wallpaper->image_height = cairo_image_surface_get_height(wallpaper->image_surface);
-	
-	wlr_log(WLR_INFO, "Loaded wallpaper: %s (%dx%d)", path, 
-		wallpaper->image_width, wallpaper->image_height);
-	
-	wallpaper->loaded = true;
+
+	// The current image stays visible until the new one has been decoded
+	wallpaper_image_unref(wallpaper->pending_image);
+	wallpaper->pending_image = image;
 	return true;
 }
 
-void nedm_wallpaper_render(struct nedm_wallpaper *wallpaper) {
-	if (!wallpaper->loaded || !wallpaper->image_surface || !wallpaper->render_surface) {
-		return;
+/* Rasterize the wallpaper at the resolution of the output. This is only used
+ * for tiling and for the pixman renderer, which would otherwise scale the
+ * image on every repaint. Runs on the worker. */
+static cairo_surface_t *
+wallpaper_rasterize(const struct nedm_wallpaper_render *render,
+                    cairo_surface_t *image) {
+	int width = ceil(render->width * render->scale);
+	int height = ceil(render->height * render->scale);
+	cairo_surface_t *surface =
+	    cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+	if(cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+		cairo_surface_destroy(surface);
+		return NULL;
 	}
-	
-	struct nedm_wallpaper_config *config = &wallpaper->output->server->wallpaper_config;
-	
+	cairo_t *cairo = cairo_create(surface);
+
 	// Clear the render surface with configured background color
-	cairo_set_source_rgba(wallpaper->cairo, 
-		config->bg_color[0], config->bg_color[1], config->bg_color[2], config->bg_color[3]);
-	cairo_paint(wallpaper->cairo);
-	
-	// Calculate scaling and positioning
+	cairo_set_source_rgba(cairo, render->bg_color[0], render->bg_color[1],
+	                      render->bg_color[2], render->bg_color[3]);
+	cairo_paint(cairo);
+
+	// Calculate scaling and positioning in layout coordinates
 	double scale_x, scale_y, offset_x, offset_y;
-	wallpaper_calculate_scaling(wallpaper, &scale_x, &scale_y, &offset_x, &offset_y);
-	
-	if (wallpaper->mode == NEDM_WALLPAPER_TILE) {
-		// Special handling for tile mode
-		cairo_pattern_t *pattern = cairo_pattern_create_for_surface(wallpaper->image_surface);
-		cairo_pattern_set_extend(pattern, CAIRO_EXTEND_REPEAT);
-		cairo_set_source(wallpaper->cairo, pattern);
-		cairo_paint(wallpaper->cairo);
-		cairo_pattern_destroy(pattern);
+	wallpaper_calculate_scaling(render->mode,
+	                            cairo_image_surface_get_width(image),
+	                            cairo_image_surface_get_height(image),
+	                            render->width, render->height, render->scale,
+	                            &scale_x, &scale_y, &offset_x, &offset_y);
+
+	cairo_scale(cairo, (double)width / render->width,
+	            (double)height / render->height);
+	cairo_translate(cairo, offset_x, offset_y);
+	cairo_scale(cairo, scale_x, scale_y);
+	cairo_set_source_surface(cairo, image, 0, 0);
+	if(render->mode == NEDM_WALLPAPER_TILE) {
+		cairo_pattern_set_extend(cairo_get_source(cairo), CAIRO_EXTEND_REPEAT);
+	}
+	cairo_paint(cairo);
+	cairo_destroy(cairo);
+	return surface;
+}
+
+static void
+wallpaper_render_unref(struct nedm_wallpaper_render *render) {
+	if(render == NULL || --render->refcount > 0) {
+		return;
+	}
+	wl_list_remove(&render->link);
+	if(render->buffer != NULL) {
+		wlr_buffer_unlock(render->buffer);
+	}
+	wallpaper_image_unref(render->image);
+	free(render);
+}
+
+static void
+wallpaper_render_run(struct nedm_worker_job *base) {
+	struct wallpaper_render_job *job = wl_container_of(base, job, base);
+	job->surface = wallpaper_rasterize(job->render, job->image);
+}
+
+static void
+wallpaper_render_done(struct nedm_worker_job *base, bool cancelled) {
+	struct wallpaper_render_job *job = wl_container_of(base, job, base);
+	struct nedm_server *server = job->server;
+	struct nedm_wallpaper_render *render = job->render;
+	cairo_surface_t *surface = job->surface;
+	cairo_surface_destroy(job->image);
+	free(job);
+
+	render->rendering = false;
+	if(cancelled) {
+		cairo_surface_destroy(surface);
+		wallpaper_render_unref(render);
+		return;
+	}
+	if(surface == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate wallpaper of size %dx%d",
+		        render->width, render->height);
 	} else {
-		// Apply transformation
-		cairo_save(wallpaper->cairo);
-		cairo_translate(wallpaper->cairo, offset_x, offset_y);
-		cairo_scale(wallpaper->cairo, scale_x, scale_y);
-		
-		// Draw the image
-		cairo_set_source_surface(wallpaper->cairo, wallpaper->image_surface, 0, 0);
-		cairo_paint(wallpaper->cairo);
-		
-		cairo_restore(wallpaper->cairo);
-	}
-	
-	// Flush the surface
-	cairo_surface_flush(wallpaper->render_surface);
-}
-
-static void wallpaper_handle_output_destroy(struct wl_listener *listener, void *data) {
+		struct wlr_buffer *buffer = wallpaper_buffer_create(surface);
+		if(buffer != NULL) {
+			render->buffer =
+			    wallpaper_buffer_upload(server->renderer, buffer);
+		}
+	}
+
+	struct nedm_wallpaper *wallpaper, *tmp;
+	wl_list_for_each_safe(wallpaper, tmp, &server->wallpapers, link) {
+		if(wallpaper->pending_render == render) {
+			nedm_wallpaper_render(wallpaper);
+		}
+	}
+	wallpaper_render_unref(render);
+}
+
+/* Returns a reference to the wallpaper rasterized for the geometry of the
+ * output, which is shared by all outputs with the same size, scale and
+ * settings. New renders are rasterized on the worker and do not have a buffer
+ * until they are done. */
+static struct nedm_wallpaper_render *
+wallpaper_render_get(struct nedm_wallpaper *wallpaper) {
+	struct nedm_server *server = wallpaper->output->server;
+	float *bg_color = server->wallpaper_config.bg_color;
+	struct nedm_wallpaper_render *render;
+	wl_list_for_each(render, &server->wallpaper_renders, link) {
+		if(render->image == wallpaper->image &&
+		   render->width == wallpaper->output_width &&
+		   render->height == wallpaper->output_height &&
+		   render->scale == wallpaper->output_scale &&
+		   render->mode == wallpaper->mode &&
+		   memcmp(render->bg_color, bg_color, sizeof(render->bg_color)) == 0) {
+			++render->refcount;
+			return render;
+		}
+	}
+
+	render = calloc(1, sizeof(*render));
+	struct wallpaper_render_job *job = calloc(1, sizeof(*job));
+	if(render == NULL || job == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate wallpaper render");
+		free(render);
+		free(job);
+		return NULL;
+	}
+	render->image = wallpaper->image;
+	++render->image->refcount;
+	render->width = wallpaper->output_width;
+	render->height = wallpaper->output_height;
+	render->scale = wallpaper->output_scale;
+	render->mode = wallpaper->mode;
+	memcpy(render->bg_color, bg_color, sizeof(render->bg_color));
+	render->refcount = 2; // The caller and the job
+	render->rendering = true;
+	wl_list_insert(&server->wallpaper_renders, &render->link);
+
+	job->base.run = wallpaper_render_run;
+	job->base.done = wallpaper_render_done;
+	job->server = server;
+	job->render = render;
+	job->image = cairo_surface_reference(render->image->surface);
+	worker_submit(server, &job->base);
+	return render;
+}
+
+static uint64_t
+buffer_size(struct wlr_buffer *buffer) {
+	return (uint64_t)buffer->width * buffer->height * 4;
+}
+
+void
+nedm_wallpaper_cache_stats(struct nedm_server *server,
+                           struct nedm_wallpaper_cache_stats *stats) {
+	memset(stats, 0, sizeof(*stats));
+	struct nedm_wallpaper_image *image;
+	wl_list_for_each(image, &server->wallpaper_images, link) {
+		++stats->images;
+		if(image->surface != NULL) {
+			stats->cpu_bytes +=
+			    (uint64_t)cairo_image_surface_get_stride(image->surface) *
+			    image->height;
+		}
+		if(image->buffer != NULL && wlr_client_buffer_get(image->buffer)) {
+			stats->gpu_bytes += buffer_size(image->buffer);
+		}
+	}
+	struct nedm_wallpaper_render *render;
+	wl_list_for_each(render, &server->wallpaper_renders, link) {
+		++stats->renders;
+		if(render->buffer == NULL) {
+			continue;
+		}
+		if(wlr_client_buffer_get(render->buffer)) {
+			stats->gpu_bytes += buffer_size(render->buffer);
+		} else {
+			stats->cpu_bytes += buffer_size(render->buffer);
+		}
+	}
+}
+
+/* Stop fading, only the current image stays visible */
+static void
+wallpaper_fade_finish(struct nedm_wallpaper *wallpaper) {
+	wallpaper->fade_pending = false;
+	if(wallpaper->fade_timer != NULL) {
+		wl_event_source_timer_update(wallpaper->fade_timer, 0);
+	}
+	wlr_scene_buffer_set_opacity(wallpaper->scene_buffer, 1);
+	wlr_scene_buffer_set_buffer(wallpaper->old_buffer, NULL);
+	wlr_scene_node_set_enabled(&wallpaper->old_buffer->node, false);
+}
+
+static void
+wallpaper_fade_step(struct nedm_wallpaper *wallpaper) {
+	int transition_time =
+	    wallpaper->output->server->wallpaper_config.transition_time;
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	int64_t elapsed = (now.tv_sec - wallpaper->fade_start.tv_sec) * 1000 +
+	                  (now.tv_nsec - wallpaper->fade_start.tv_nsec) / 1000000;
+	if(wallpaper->fade_timer == NULL || elapsed >= transition_time) {
+		wallpaper_fade_finish(wallpaper);
+		return;
+	}
+	/* The scene blends both buffers, only the opacity changes per frame */
+	wlr_scene_buffer_set_opacity(wallpaper->scene_buffer,
+	                             (float)elapsed / transition_time);
+	int refresh = wallpaper->output->wlr_output->refresh;
+	int interval = refresh > 0 ? 1000000 / refresh : 16;
+	wl_event_source_timer_update(wallpaper->fade_timer,
+	                             interval > 0 ? interval : 1);
+}
+
+static int
+handle_wallpaper_fade_timer(void *data) {
+	wallpaper_fade_step(data);
+	return 0;
+}
+
+/* Move the current image to old_buffer, the next image is shown in the other
+ * scene buffer and faded in on top of it */
+static void
+wallpaper_fade_prepare(struct nedm_wallpaper *wallpaper) {
+	wallpaper_fade_finish(wallpaper);
+	if(!wallpaper->scene_buffer->node.enabled) {
+		return;
+	}
+	struct wlr_scene_buffer *old_buffer = wallpaper->scene_buffer;
+	wallpaper->scene_buffer = wallpaper->old_buffer;
+	wallpaper->old_buffer = old_buffer;
+	wlr_scene_buffer_set_opacity(wallpaper->scene_buffer, 0);
+	wlr_scene_node_raise_to_top(&wallpaper->scene_buffer->node);
+	wlr_scene_node_set_enabled(&wallpaper->scene_buffer->node, true);
+	wallpaper->fade_pending = true;
+}
+
+/* Called once scene_buffer shows the current image */
+static void
+wallpaper_shown(struct nedm_wallpaper *wallpaper) {
+	if(!wallpaper->fade_pending || wallpaper->pending_image != NULL) {
+		return;
+	}
+	wallpaper->fade_pending = false;
+	clock_gettime(CLOCK_MONOTONIC, &wallpaper->fade_start);
+	wallpaper_fade_step(wallpaper);
+}
+
+static void
+wallpaper_hide(struct nedm_wallpaper *wallpaper) {
+	wlr_scene_node_set_enabled(&wallpaper->scene_buffer->node, false);
+	wallpaper_fade_finish(wallpaper);
+}
+
+/* Let the renderer scale the uploaded image, only the visible part of the
+ * image is sampled */
+static void
+wallpaper_render_gpu(struct nedm_wallpaper *wallpaper) {
+	double scale_x, scale_y, offset_x, offset_y;
+	wallpaper_calculate_scaling(wallpaper->mode, wallpaper->image_width,
+	                            wallpaper->image_height,
+	                            wallpaper->output_width,
+	                            wallpaper->output_height,
+	                            wallpaper->output_scale, &scale_x, &scale_y,
+	                            &offset_x, &offset_y);
+
+	double x1 = fmax(offset_x, 0);
+	double y1 = fmax(offset_y, 0);
+	double x2 = fmin(offset_x + wallpaper->image_width * scale_x,
+	                 wallpaper->output_width);
+	double y2 = fmin(offset_y + wallpaper->image_height * scale_y,
+	                 wallpaper->output_height);
+	if(x2 <= x1 || y2 <= y1) {
+		wallpaper_hide(wallpaper);
+		return;
+	}
+
+	struct wlr_fbox src = {
+	    .x = (x1 - offset_x) / scale_x,
+	    .y = (y1 - offset_y) / scale_y,
+	    .width = (x2 - x1) / scale_x,
+	    .height = (y2 - y1) / scale_y,
+	};
+	int x = round(x1);
+	int y = round(y1);
+	int width = round(x2) - x;
+	int height = round(y2) - y;
+
+	wlr_scene_buffer_set_buffer(wallpaper->scene_buffer,
+	                            wallpaper->image->buffer);
+	wlr_scene_buffer_set_source_box(wallpaper->scene_buffer, &src);
+	wlr_scene_buffer_set_dest_size(wallpaper->scene_buffer, width, height);
+	wlr_scene_node_set_position(&wallpaper->scene_buffer->node, x, y);
+	wlr_scene_node_set_enabled(&wallpaper->scene_buffer->node,
+	                           width > 0 && height > 0);
+
+	// The uploaded texture has no format the scene could tell opacity from
+	pixman_region32_t opaque;
+	pixman_region32_init(&opaque);
+	if(wallpaper->image->opaque) {
+		pixman_region32_union_rect(&opaque, &opaque, 0, 0, width, height);
+	}
+	wlr_scene_buffer_set_opaque_region(wallpaper->scene_buffer, &opaque);
+	pixman_region32_fini(&opaque);
+	wallpaper_shown(wallpaper);
+}
+
+/* Whether the image was decoded at a sufficient size for the output */
+static bool
+wallpaper_image_sufficient(const struct nedm_wallpaper *wallpaper,
+                           const struct nedm_wallpaper_image *image) {
+	uint32_t width, height;
+	enum nedm_image_fit fit = wallpaper_image_fit(wallpaper, &width, &height);
+	return image->fit == fit && image->target_width >= width &&
+	       image->target_height >= height;
+}
+
+static void
+wallpaper_update_geometry(struct nedm_wallpaper *wallpaper) {
+	int width, height;
+	wlr_output_effective_resolution(wallpaper->output->wlr_output, &width,
+	                                &height);
+	wallpaper->output_width = width;
+	wallpaper->output_height = height;
+	wallpaper->output_scale = wallpaper->output->wlr_output->scale;
+}
+
+/* Update the scene nodes of the wallpaper for the current geometry of the
+ * output */
+void
+nedm_wallpaper_render(struct nedm_wallpaper *wallpaper) {
+	struct nedm_output *output = wallpaper->output;
+	wallpaper_update_geometry(wallpaper);
+	int width = wallpaper->output_width;
+	int height = wallpaper->output_height;
+
+	struct wlr_box box = output_get_layout_box(output);
+	wlr_scene_node_set_position(&wallpaper->tree->node, box.x, box.y);
+	wlr_scene_rect_set_size(wallpaper->background, width, height);
+
+	/* If the output grew beyond the size the image was downsampled to, it
+	 * is decoded again. Until then, the current image is scaled up. */
+	struct nedm_wallpaper_image *latest =
+	    wallpaper->pending_image ? wallpaper->pending_image : wallpaper->image;
+	if(latest && !wallpaper_image_sufficient(wallpaper, latest)) {
+		nedm_wallpaper_load_image(wallpaper, wallpaper->image_path);
+	}
+
+	// Swap in a newly loaded image once it has been decoded
+	if(wallpaper->pending_image && !wallpaper->pending_image->decoding) {
+		wallpaper_image_unref(wallpaper->image);
+		wallpaper->image = wallpaper->pending_image;
+		wallpaper->pending_image = NULL;
+	}
+
+	struct nedm_wallpaper_image *image = wallpaper->image;
+	if(!image || !wallpaper_image_ready(image, wallpaper->cpu_render)) {
+		// The background color is shown until the image is decoded
+		if(!image || !image->decoding) {
+			wallpaper_hide(wallpaper);
+		}
+		return;
+	}
+	wallpaper->image_width = image->width;
+	wallpaper->image_height = image->height;
+
+	if(!wallpaper->cpu_render) {
+		wallpaper_render_unref(wallpaper->render);
+		wallpaper->render = NULL;
+		wallpaper_render_unref(wallpaper->pending_render);
+		wallpaper->pending_render = NULL;
+		wallpaper_render_gpu(wallpaper);
+		return;
+	}
+
+	struct nedm_wallpaper_render *render = wallpaper_render_get(wallpaper);
+	wallpaper_render_unref(wallpaper->pending_render);
+	wallpaper->pending_render = NULL;
+	if(render && !render->buffer && render->rendering) {
+		// Keep the previous buffer until the new one has been rasterized
+		wallpaper->pending_render = render;
+		if(!wallpaper->render) {
+			wallpaper_hide(wallpaper);
+		}
+		return;
+	}
+	wallpaper_render_unref(wallpaper->render);
+	wallpaper->render = render;
+	if(!render || !render->buffer) {
+		wallpaper_hide(wallpaper);
+		return;
+	}
+	// Replaced in a single scene update, so no frame shows a partial state
+	wlr_scene_buffer_set_buffer(wallpaper->scene_buffer, render->buffer);
+	wlr_scene_buffer_set_source_box(wallpaper->scene_buffer, NULL);
+	wlr_scene_buffer_set_dest_size(wallpaper->scene_buffer, width, height);
+	wlr_scene_node_set_position(&wallpaper->scene_buffer->node, 0, 0);
+	wlr_scene_node_set_enabled(&wallpaper->scene_buffer->node, true);
+	wallpaper_shown(wallpaper);
+}
+
+static void
+wallpaper_handle_output_destroy(struct wl_listener *listener, void *data) {
 	(void)data;
-	struct nedm_wallpaper *wallpaper = wl_container_of(listener, wallpaper, output_destroy);
+	struct nedm_wallpaper *wallpaper =
+	    wl_container_of(listener, wallpaper, output_destroy);
 	nedm_wallpaper_destroy(wallpaper);
 }
 
-void nedm_wallpaper_create_for_output(struct nedm_output *output) {
-	if (!output || !output->server) {
+/* Decode the next image of the slideshow while the current one is shown */
+static void
+wallpaper_slideshow_preload(struct nedm_wallpaper *wallpaper) {
+	struct nedm_server *server = wallpaper->output->server;
+	struct nedm_wallpaper_slideshow *slideshow = &server->wallpaper_slideshow;
+	struct nedm_wallpaper_image *next_image = NULL;
+	if(slideshow->timer != NULL && slideshow->nimages > 1 &&
+	   server->wallpaper_config.slideshow_interval > 0) {
+		uint32_t width, height;
+		enum nedm_image_fit fit =
+		    wallpaper_image_fit(wallpaper, &width, &height);
+		const char *path =
+		    slideshow->images[(slideshow->current + 1) % slideshow->nimages];
+		next_image = wallpaper_image_get(server, path, wallpaper->cpu_render,
+		                                 width, height, fit);
+	}
+	wallpaper_image_unref(wallpaper->next_image);
+	wallpaper->next_image = next_image;
+}
+
+static int
+handle_slideshow_timer(void *data) {
+	struct nedm_server *server = data;
+	struct nedm_wallpaper_slideshow *slideshow = &server->wallpaper_slideshow;
+	struct nedm_wallpaper_config *config = &server->wallpaper_config;
+	if(slideshow->nimages < 2 || config->slideshow_interval <= 0) {
+		return 0;
+	}
+	slideshow->current = (slideshow->current + 1) % slideshow->nimages;
+	char *image_path = strdup(slideshow->images[slideshow->current]);
+	if(image_path != NULL) {
+		free(config->image_path);
+		config->image_path = image_path;
+		struct nedm_wallpaper *wallpaper;
+		wl_list_for_each(wallpaper, &server->wallpapers, link) {
+			wallpaper_fade_prepare(wallpaper);
+			nedm_wallpaper_configure(wallpaper);
+		}
+	}
+	wl_event_source_timer_update(slideshow->timer,
+	                             config->slideshow_interval * 1000);
+	return 0;
+}
+
+static bool
+slideshow_is_image(const char *name) {
+	const char *ext = strrchr(name, '.');
+	return ext != NULL &&
+	       (strcasecmp(ext, ".png") == 0 || strcasecmp(ext, ".jpg") == 0 ||
+	        strcasecmp(ext, ".jpeg") == 0);
+}
+
+static int
+slideshow_compare(const void *a, const void *b) {
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void
+slideshow_add_image(struct nedm_wallpaper_slideshow *slideshow, char *path) {
+	char **images = realloc(slideshow->images,
+	                        (slideshow->nimages + 1) * sizeof(char *));
+	if(path == NULL || images == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate wallpaper slideshow");
+		free(path);
+		if(images != NULL) {
+			slideshow->images = images;
+		}
+		return;
+	}
+	slideshow->images = images;
+	slideshow->images[slideshow->nimages++] = path;
+}
+
+/* Adds the images of a directory in alphabetical order */
+static void
+slideshow_add_directory(struct nedm_wallpaper_slideshow *slideshow,
+                        const char *path) {
+	DIR *dir = opendir(path);
+	if(dir == NULL) {
+		wlr_log_errno(WLR_ERROR, "Failed to open slideshow directory %s",
+		              path);
+		return;
+	}
+	uint32_t first = slideshow->nimages;
+	struct dirent *entry;
+	while((entry = readdir(dir)) != NULL) {
+		if(entry->d_name[0] == '.' || !slideshow_is_image(entry->d_name)) {
+			continue;
+		}
+		slideshow_add_image(slideshow, malloc_vsprintf("%s/%s", path,
+		                                               entry->d_name));
+	}
+	closedir(dir);
+	qsort(slideshow->images + first, slideshow->nimages - first,
+	      sizeof(char *), slideshow_compare);
+}
+
+static void
+slideshow_clear(struct nedm_wallpaper_slideshow *slideshow) {
+	for(uint32_t i = 0; i < slideshow->nimages; ++i) {
+		free(slideshow->images[i]);
+	}
+	free(slideshow->images);
+	slideshow->images = NULL;
+	slideshow->nimages = 0;
+	slideshow->current = 0;
+}
+
+/* Rebuild the list of images from the configuration and start over with the
+ * first image. The wallpapers have to be configured afterwards. */
+void
+nedm_wallpaper_slideshow_configure(struct nedm_server *server) {
+	struct nedm_wallpaper_slideshow *slideshow = &server->wallpaper_slideshow;
+	struct nedm_wallpaper_config *config = &server->wallpaper_config;
+	slideshow_clear(slideshow);
+
+	char *paths = config->slideshow ? strdup(config->slideshow) : NULL;
+	char *saveptr = NULL;
+	for(char *path = paths ? strtok_r(paths, ":", &saveptr) : NULL;
+	    path != NULL; path = strtok_r(NULL, ":", &saveptr)) {
+		struct stat st;
+		if(stat(path, &st) != 0) {
+			wlr_log(WLR_ERROR, "Failed to stat slideshow image: %s", path);
+		} else if(S_ISDIR(st.st_mode)) {
+			slideshow_add_directory(slideshow, path);
+		} else {
+			slideshow_add_image(slideshow, strdup(path));
+		}
+	}
+	free(paths);
+
+	if(slideshow->timer == NULL && server->event_loop != NULL) {
+		slideshow->timer = wl_event_loop_add_timer(
+		    server->event_loop, handle_slideshow_timer, server);
+	}
+	bool enabled = slideshow->nimages > 0 && config->slideshow_interval > 0;
+	if(slideshow->timer != NULL) {
+		wl_event_source_timer_update(
+		    slideshow->timer, enabled ? config->slideshow_interval * 1000 : 0);
+	}
+	if(!enabled) {
+		return;
+	}
+	char *image_path = strdup(slideshow->images[0]);
+	if(image_path != NULL) {
+		free(config->image_path);
+		config->image_path = image_path;
+	}
+}
+
+/* Apply the current wallpaper configuration of the server */
+void
+nedm_wallpaper_configure(struct nedm_wallpaper *wallpaper) {
+	struct nedm_server *server = wallpaper->output->server;
+	struct nedm_wallpaper_config *config = &server->wallpaper_config;
+
+	wallpaper->mode = config->mode;
+	wallpaper->cpu_render = wallpaper->mode == NEDM_WALLPAPER_TILE ||
+	                        wlr_renderer_is_pixman(server->renderer);
+	wlr_scene_rect_set_color(wallpaper->background, config->bg_color);
+	wallpaper_update_geometry(wallpaper);
+
+	free(wallpaper->image_path);
+	wallpaper->image_path =
+	    strdup(config->image_path ? config->image_path : "assets/nedm.png");
+	if(!wallpaper->image_path ||
+	   !nedm_wallpaper_load_image(wallpaper, wallpaper->image_path)) {
+		wlr_log(WLR_ERROR, "Failed to load wallpaper image");
+		wallpaper_image_unref(wallpaper->image);
+		wallpaper->image = NULL;
+	}
+
+	nedm_wallpaper_render(wallpaper);
+	wallpaper_slideshow_preload(wallpaper);
+}
+
+void
+nedm_wallpaper_create_for_output(struct nedm_output *output) {
+	if(!output || !output->server) {
 		wlr_log(WLR_ERROR, "Invalid output or server for wallpaper creation");
 		return;
 	}
-	
-	struct nedm_wallpaper *wallpaper = calloc(1, sizeof(struct nedm_wallpaper));
-	if (!wallpaper) {
+
+	struct nedm_wallpaper *wallpaper =
+	    calloc(1, sizeof(struct nedm_wallpaper));
+	if(!wallpaper) {
 		wlr_log(WLR_ERROR, "Failed to allocate wallpaper");
 		return;
 	}
-	
+
 	wallpaper->output = output;
 	output->wallpaper = wallpaper;
-	
+
 	struct nedm_wallpaper_config *config = &output->server->wallpaper_config;
-	
-	// Set output dimensions
-	wallpaper->output_width = output->wlr_output->width;
-	wallpaper->output_height = output->wlr_output->height;
-	
-	// Use configured wallpaper mode
-	wallpaper->mode = config->mode;
-	
-	// Store the image path
-	wallpaper->image_path = strdup(config->image_path ? config->image_path : "assets/nedm.png");
-	
-	// Create render surface
-	wallpaper->render_surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, 
-		wallpaper->output_width, wallpaper->output_height);
-	wallpaper->cairo = cairo_create(wallpaper->render_surface);
-	
-	// Load the wallpaper image
-	if (!nedm_wallpaper_load_image(wallpaper, wallpaper->image_path)) {
-		wlr_log(WLR_ERROR, "Failed to load wallpaper image");
+
+	// The background color is shown around the image and if it fails to load
+	wallpaper->tree = wlr_scene_tree_create(output->layers[0]);
+	if(!wallpaper->tree) {
+		wlr_log(WLR_ERROR, "Failed to create scene tree for wallpaper");
 		nedm_wallpaper_destroy(wallpaper);
 		return;
 	}
-	
-	// Render the wallpaper first
-	nedm_wallpaper_render(wallpaper);
-	
-	// Create a scene buffer from the rendered wallpaper
-	wallpaper->scene_buffer = wlr_scene_buffer_create(output->layers[0], NULL);
-	if (!wallpaper->scene_buffer) {
+	wallpaper->background =
+	    wlr_scene_rect_create(wallpaper->tree, 0, 0, config->bg_color);
+	wallpaper->old_buffer = wlr_scene_buffer_create(wallpaper->tree, NULL);
+	wallpaper->scene_buffer = wlr_scene_buffer_create(wallpaper->tree, NULL);
+	if(!wallpaper->background || !wallpaper->old_buffer ||
+	   !wallpaper->scene_buffer) {
 		wlr_log(WLR_ERROR, "Failed to create scene buffer for wallpaper");
 		nedm_wallpaper_destroy(wallpaper);
 		return;
 	}
-	
-	if (wallpaper->render_surface) {
-		cairo_surface_flush(wallpaper->render_surface);
-		unsigned char *data = cairo_image_surface_get_data(wallpaper->render_surface);
-		int stride = cairo_image_surface_get_stride(wallpaper->render_surface);
-		
-		struct wallpaper_buffer *buf = wallpaper_buffer_create(wallpaper->output_width, wallpaper->output_height, stride);
-		if (buf) {
-			void *data_ptr;
-			if(wlr_buffer_begin_data_ptr_access(&buf->base,
-			                                     WLR_BUFFER_DATA_PTR_ACCESS_WRITE,
-			                                     &data_ptr, NULL, NULL)) {
-				memcpy(data_ptr, data, stride * wallpaper->output_height);
-				wlr_buffer_end_data_ptr_access(&buf->base);
-				
-				wlr_scene_buffer_set_buffer(wallpaper->scene_buffer, &buf->base);
-				wlr_buffer_drop(&buf->base);
-			}
-		}
-	}
-	
-	// Position the wallpaper at (0, 0) to cover the entire output
-	wlr_scene_node_set_position(&wallpaper->scene_buffer->node, 0, 0);
-	
+
+	wlr_scene_node_set_enabled(&wallpaper->old_buffer->node, false);
+	wallpaper->fade_timer = wl_event_loop_add_timer(
+	    output->server->event_loop, handle_wallpaper_fade_timer, wallpaper);
+
 	// Set up event listeners
 	wallpaper->output_destroy.notify = wallpaper_handle_output_destroy;
 	wl_signal_add(&output->events.destroy, &wallpaper->output_destroy);
-	
-	wlr_log(WLR_INFO, "Created wallpaper for output %s (%dx%d) with image %s", 
-		output->wlr_output->name, wallpaper->output_width, wallpaper->output_height, 
-		wallpaper->image_path);
+	wl_list_insert(&output->server->wallpapers, &wallpaper->link);
+
+	// The image is shown once it has been decoded
+	nedm_wallpaper_configure(wallpaper);
+
+	wlr_log(WLR_INFO, "Created wallpaper for output %s (%dx%d) with image %s",
+	        output->wlr_output->name, wallpaper->output_width,
+	        wallpaper->output_height, wallpaper->image_path);
 }
 
-void nedm_wallpaper_destroy(struct nedm_wallpaper *wallpaper) {
-	if (!wallpaper) {
+void
+nedm_wallpaper_destroy(struct nedm_wallpaper *wallpaper) {
+	if(!wallpaper) {
 		return;
 	}
-	
-	if (wallpaper->scene_buffer) {
-		wlr_scene_node_destroy(&wallpaper->scene_buffer->node);
-	}
-	
-	if (wallpaper->cairo) {
-		cairo_destroy(wallpaper->cairo);
-	}
-	
-	if (wallpaper->render_surface) {
-		cairo_surface_destroy(wallpaper->render_surface);
+
+	if(wallpaper->fade_timer) {
+		wl_event_source_remove(wallpaper->fade_timer);
+		wallpaper->fade_timer = NULL;
 	}
-	
-	if (wallpaper->image_surface) {
-		cairo_surface_destroy(wallpaper->image_surface);
+
+	// Destroys scene_buffer and old_buffer as well
+	if(wallpaper->tree) {
+		wlr_scene_node_destroy(&wallpaper->tree->node);
 	}
-	
-	if (wallpaper->image_path) {
+	wallpaper->scene_buffer = NULL;
+	wallpaper->old_buffer = NULL;
+
+	wallpaper_render_unref(wallpaper->render);
+	wallpaper_render_unref(wallpaper->pending_render);
+	wallpaper_image_unref(wallpaper->image);
+	wallpaper_image_unref(wallpaper->pending_image);
+	wallpaper_image_unref(wallpaper->next_image);
+
+	if(wallpaper->image_path) {
 		free(wallpaper->image_path);
 	}
-	
-	if (wallpaper->output_destroy.notify) {
+
+	if(wallpaper->output_destroy.notify) {
 		wl_list_remove(&wallpaper->output_destroy.link);
+		wl_list_remove(&wallpaper->link);
 	}
-	
-	if (wallpaper->output) {
+
+	if(wallpaper->output) {
 		wallpaper->output->wallpaper = NULL;
 	}
-	
+
 	free(wallpaper);
 }
 
-void nedm_wallpaper_init(struct nedm_server *server) {
-	(void)server;
-	// Wallpapers are created per-output, so nothing to initialize globally
+void
+nedm_wallpaper_init(struct nedm_server *server) {
+	// Wallpapers are created per-output, decoded images are shared
+	wl_list_init(&server->wallpapers);
+	wl_list_init(&server->wallpaper_images);
+	wl_list_init(&server->wallpaper_renders);
 	wlr_log(WLR_INFO, "Wallpaper subsystem initialized");
-}
\ No newline at end of file
+}
+
+void
+nedm_wallpaper_finish(struct nedm_server *server) {
+	struct nedm_wallpaper_slideshow *slideshow = &server->wallpaper_slideshow;
+	slideshow_clear(slideshow);
+	if(slideshow->timer) {
+		wl_event_source_remove(slideshow->timer);
+		slideshow->timer = NULL;
+	}
+}
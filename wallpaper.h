@@ -7,6 +7,11 @@
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_scene.h>
 #include <cairo.h>
+#include <stdint.h>
+
+#include "image.h"
+#include <sys/types.h>
+#include <time.h>
 
 struct nedm_server;
 struct nedm_output;
@@ -17,39 +22,130 @@ enum nedm_wallpaper_mode {
 	NEDM_WALLPAPER_STRETCH,
 	NEDM_WALLPAPER_CENTER,
 	NEDM_WALLPAPER_TILE,
+	NEDM_WALLPAPER_NOPT
 };
 
 struct nedm_wallpaper_config {
 	char *image_path;
 	enum nedm_wallpaper_mode mode;
 	float bg_color[4]; // fallback color if image fails to load
+	char *slideshow;        // Colon separated list of images or directories
+	int slideshow_interval; // in seconds, 0 disables the slideshow
+	int transition_time;    // Length of the crossfade in milliseconds
+};
+
+/* Images of the slideshow, which are shown on all outputs in turn */
+struct nedm_wallpaper_slideshow {
+	char **images;
+	uint32_t nimages;
+	uint32_t current;
+	struct wl_event_source *timer;
+};
+
+/* Decoded wallpaper image, shared by all outputs showing the same file at the
+ * same size for as long as its modification time and size do not change */
+struct nedm_wallpaper_image {
+	char *path;
+	struct timespec mtime;
+	off_t size;
+	/* Size the image was downsampled to while decoding, in pixels */
+	enum nedm_image_fit fit;
+	uint32_t target_width;
+	uint32_t target_height;
+	int refcount;
+	uint32_t width;
+	uint32_t height;
+	bool opaque;
+	bool cpu; // Rendered on the CPU by at least one output
+	bool gpu; // Scaled by the renderer for at least one output
+	bool decoding; // A decode job is queued on the worker
+	bool failed;
+	/* Decoded pixels, only kept if the image is rendered on the CPU */
+	cairo_surface_t *surface;
+	/* Image uploaded to the GPU, which is scaled by the renderer */
+	struct wlr_buffer *buffer;
+	struct wl_list link; // nedm_server::wallpaper_images
+};
+
+/* Wallpaper rasterized on the CPU, shared by all outputs with the same
+ * resolution, scale and mode */
+struct nedm_wallpaper_render {
+	struct nedm_wallpaper_image *image;
+	uint32_t width; // in layout coordinates
+	uint32_t height;
+	float scale;
+	enum nedm_wallpaper_mode mode;
+	float bg_color[4];
+	int refcount;
+	bool rendering; // A render job is queued on the worker
+	struct wlr_buffer *buffer;
+	struct wl_list link; // nedm_server::wallpaper_renders
+};
+
+struct nedm_wallpaper_cache_stats {
+	uint32_t images;
+	uint32_t renders;
+	uint64_t cpu_bytes;
+	uint64_t gpu_bytes;
 };
 
 struct nedm_wallpaper {
+	struct wlr_scene_tree *tree; // Positioned at the output
+	struct wlr_scene_rect *background; // bg_color, visible around the image
 	struct wlr_scene_buffer *scene_buffer;
+	/* Shows the previous image while scene_buffer fades in on top of it */
+	struct wlr_scene_buffer *old_buffer;
 	struct nedm_output *output;
 	
-	cairo_surface_t *image_surface;
-	cairo_surface_t *render_surface;
-	cairo_t *cairo;
+	struct nedm_wallpaper_image *image;
+	struct nedm_wallpaper_render *render; // Only set if rendered on the CPU
+	/* Shown as soon as the worker is done with them */
+	struct nedm_wallpaper_image *pending_image;
+	struct nedm_wallpaper_render *pending_render;
+	/* Next image of the slideshow, decoded ahead of time */
+	struct nedm_wallpaper_image *next_image;
 	
 	char *image_path;
 	enum nedm_wallpaper_mode mode;
 	
-	uint32_t output_width;
+	uint32_t output_width;  // in layout coordinates
 	uint32_t output_height;
+	float output_scale;
 	uint32_t image_width;
 	uint32_t image_height;
 	
 	struct wl_listener output_destroy;
+	struct wl_list link; // nedm_server::wallpapers
+
+	/* Crossfade to a new slideshow image, which starts as soon as the image
+	 * is shown */
+	bool fade_pending;
+	struct timespec fade_start;
+	struct wl_event_source *fade_timer;
 	
-	bool loaded;
+	/* Tiled wallpapers and wallpapers of the pixman renderer are rasterized
+	 * at the resolution of the output */
+	bool cpu_render;
 };
 
-void nedm_wallpaper_init(struct nedm_server *server);
-void nedm_wallpaper_destroy(struct nedm_wallpaper *wallpaper);
-void nedm_wallpaper_create_for_output(struct nedm_output *output);
-void nedm_wallpaper_render(struct nedm_wallpaper *wallpaper);
-bool nedm_wallpaper_load_image(struct nedm_wallpaper *wallpaper, const char *path);
+void
+nedm_wallpaper_init(struct nedm_server *server);
+void
+nedm_wallpaper_finish(struct nedm_server *server);
+void
+nedm_wallpaper_slideshow_configure(struct nedm_server *server);
+void
+nedm_wallpaper_destroy(struct nedm_wallpaper *wallpaper);
+void
+nedm_wallpaper_create_for_output(struct nedm_output *output);
+void
+nedm_wallpaper_render(struct nedm_wallpaper *wallpaper);
+void
+nedm_wallpaper_configure(struct nedm_wallpaper *wallpaper);
+bool
+nedm_wallpaper_load_image(struct nedm_wallpaper *wallpaper, const char *path);
+void
+nedm_wallpaper_cache_stats(struct nedm_server *server,
+                           struct nedm_wallpaper_cache_stats *stats);
 
 #endif
\ No newline at end of file
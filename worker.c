@@ -0,0 +1,153 @@
+// Copyright 2020 - 2025, project-repo and the NEDM contributors
+// SPDX-License-Identifier: MIT
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <wayland-server-core.h>
+#include <wlr/util/log.h>
+
+#include "server.h"
+#include "worker.h"
+
+static void
+worker_notify(struct nedm_worker *worker) {
+	uint64_t one = 1;
+	if(write(worker->eventfd, &one, sizeof(one)) != sizeof(one)) {
+		/* The counter can only overflow if the main loop does not read it,
+		 * in which case it is readable anyway */
+		wlr_log(WLR_DEBUG, "Failed to signal worker completion");
+	}
+}
+
+static void *
+worker_run(void *data) {
+	struct nedm_worker *worker = data;
+	pthread_mutex_lock(&worker->lock);
+	while(!worker->stop) {
+		if(wl_list_empty(&worker->jobs)) {
+			pthread_cond_wait(&worker->cond, &worker->lock);
+			continue;
+		}
+		struct nedm_worker_job *job =
+		    wl_container_of(worker->jobs.next, job, link);
+		wl_list_remove(&job->link);
+		pthread_mutex_unlock(&worker->lock);
+
+		job->run(job);
+
+		pthread_mutex_lock(&worker->lock);
+		wl_list_insert(worker->finished.prev, &job->link);
+		worker_notify(worker);
+	}
+	pthread_mutex_unlock(&worker->lock);
+	return NULL;
+}
+
+static int
+handle_worker_finished(int fd, uint32_t mask, void *data) {
+	(void)mask;
+	struct nedm_worker *worker = data;
+	uint64_t count;
+	if(read(fd, &count, sizeof(count)) != sizeof(count)) {
+		return 0;
+	}
+
+	struct wl_list finished;
+	wl_list_init(&finished);
+	pthread_mutex_lock(&worker->lock);
+	wl_list_insert_list(&finished, &worker->finished);
+	wl_list_init(&worker->finished);
+	pthread_mutex_unlock(&worker->lock);
+
+	struct nedm_worker_job *job, *tmp;
+	wl_list_for_each_safe(job, tmp, &finished, link) {
+		wl_list_remove(&job->link);
+		job->done(job, false);
+	}
+	return 0;
+}
+
+/* Queues the job on the worker. If there is no worker, the job is run
+ * synchronously. */
+void
+worker_submit(struct nedm_server *server, struct nedm_worker_job *job) {
+	struct nedm_worker *worker = server->worker;
+	if(worker == NULL) {
+		job->run(job);
+		job->done(job, false);
+		return;
+	}
+	pthread_mutex_lock(&worker->lock);
+	wl_list_insert(worker->jobs.prev, &job->link);
+	pthread_cond_signal(&worker->cond);
+	pthread_mutex_unlock(&worker->lock);
+}
+
+int
+worker_init(struct nedm_server *server) {
+	struct nedm_worker *worker = calloc(1, sizeof(struct nedm_worker));
+	if(worker == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate worker");
+		return -1;
+	}
+	wl_list_init(&worker->jobs);
+	wl_list_init(&worker->finished);
+	worker->eventfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if(worker->eventfd < 0) {
+		wlr_log_errno(WLR_ERROR, "Failed to create worker eventfd");
+		free(worker);
+		return -1;
+	}
+	worker->source =
+	    wl_event_loop_add_fd(server->event_loop, worker->eventfd,
+	                         WL_EVENT_READABLE, handle_worker_finished, worker);
+	if(worker->source == NULL) {
+		wlr_log(WLR_ERROR, "Failed to add worker eventfd to the event loop");
+		close(worker->eventfd);
+		free(worker);
+		return -1;
+	}
+	pthread_mutex_init(&worker->lock, NULL);
+	pthread_cond_init(&worker->cond, NULL);
+	if(pthread_create(&worker->thread, NULL, worker_run, worker) != 0) {
+		wlr_log(WLR_ERROR, "Failed to start worker thread");
+		pthread_cond_destroy(&worker->cond);
+		pthread_mutex_destroy(&worker->lock);
+		wl_event_source_remove(worker->source);
+		close(worker->eventfd);
+		free(worker);
+		return -1;
+	}
+	server->worker = worker;
+	return 0;
+}
+
+void
+worker_finish(struct nedm_server *server) {
+	struct nedm_worker *worker = server->worker;
+	if(worker == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&worker->lock);
+	worker->stop = true;
+	pthread_cond_signal(&worker->cond);
+	pthread_mutex_unlock(&worker->lock);
+	pthread_join(worker->thread, NULL);
+	server->worker = NULL;
+
+	wl_list_insert_list(&worker->finished, &worker->jobs);
+	struct nedm_worker_job *job, *tmp;
+	wl_list_for_each_safe(job, tmp, &worker->finished, link) {
+		wl_list_remove(&job->link);
+		job->done(job, true);
+	}
+
+	pthread_cond_destroy(&worker->cond);
+	pthread_mutex_destroy(&worker->lock);
+	wl_event_source_remove(worker->source);
+	close(worker->eventfd);
+	free(worker);
+}
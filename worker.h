@@ -0,0 +1,44 @@
+// Copyright 2020 - 2025, project-repo and the NEDM contributors
+// SPDX-License-Identifier: MIT
+
+#ifndef NEDM_WORKER_H
+#define NEDM_WORKER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <wayland-server-core.h>
+
+struct nedm_server;
+
+/* A unit of work which is run on the worker thread. The job must only touch
+ * data owned by itself in run. */
+struct nedm_worker_job {
+	void (*run)(struct nedm_worker_job *job);
+	/* Called on the main loop after run has returned. If the worker is shut
+	 * down first, cancelled is set and run may not have been called. */
+	void (*done)(struct nedm_worker_job *job, bool cancelled);
+	struct wl_list link; // nedm_worker::jobs or nedm_worker::finished
+};
+
+/* Background thread for expensive work (i.e. decoding images), which would
+ * otherwise block the event loop. Finished jobs are handed back to the main
+ * loop through an eventfd. */
+struct nedm_worker {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct wl_list jobs;     // Waiting to be run
+	struct wl_list finished; // Waiting for done to be called
+	bool stop;
+	int eventfd;
+	struct wl_event_source *source;
+};
+
+int
+worker_init(struct nedm_server *server);
+void
+worker_finish(struct nedm_server *server);
+void
+worker_submit(struct nedm_server *server, struct nedm_worker_job *job);
+
+#endif
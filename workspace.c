@@ -18,6 +18,7 @@
 
 void
 workspace_tile_update_view(struct nedm_tile *tile, struct nedm_view *view) {
+	++tile->workspace->server->scene_generation;
 	if(tile->view != NULL) {
 		wlr_scene_node_set_enabled(&tile->view->scene_tree->node, false);
 		tile->view->tile = NULL;
@@ -29,6 +30,224 @@ workspace_tile_update_view(struct nedm_tile *tile, struct nedm_view *view) {
 	}
 }
 
+void
+workspace_tiles_changed(struct nedm_workspace *workspace) {
+	workspace->tile_index.dirty = true;
+}
+
+static void
+tile_index_free(struct nedm_tile_index *index) {
+	free(index->xs);
+	free(index->ys);
+	free(index->cells);
+	index->xs = NULL;
+	index->ys = NULL;
+	index->cells = NULL;
+	index->nxs = 0;
+	index->nys = 0;
+}
+
+static int
+compare_int(const void *a, const void *b) {
+	int x = *(const int *)a, y = *(const int *)b;
+	return (x > y) - (x < y);
+}
+
+/* Sorts the array and removes duplicates, returns the new length */
+static uint32_t
+sort_unique(int *arr, uint32_t len) {
+	if(len == 0) {
+		return 0;
+	}
+	qsort(arr, len, sizeof(int), compare_int);
+	uint32_t n = 1;
+	for(uint32_t i = 1; i < len; ++i) {
+		if(arr[i] != arr[n - 1]) {
+			arr[n++] = arr[i];
+		}
+	}
+	return n;
+}
+
+/* Returns the position of the first element of arr which is not less than
+ * val */
+static uint32_t
+lower_bound(const int *arr, uint32_t len, double val) {
+	uint32_t lo = 0, hi = len;
+	while(lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if(arr[mid] < val) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/* Returns the position of val in arr or -1 if it does not exist */
+static int64_t
+index_of(const int *arr, uint32_t len, int val) {
+	uint32_t pos = lower_bound(arr, len, val);
+	if(pos < len && arr[pos] == val) {
+		return pos;
+	}
+	return -1;
+}
+
+/* Returns the cell i with arr[i] < val <= arr[i+1] or -1 */
+static int64_t
+cell_upper_closed(const int *arr, uint32_t len, int val) {
+	int64_t pos = (int64_t)lower_bound(arr, len, val) - 1;
+	if(pos < 0 || pos + 1 >= len) {
+		return -1;
+	}
+	return pos;
+}
+
+static int
+tile_index_update(struct nedm_workspace *workspace) {
+	struct nedm_tile_index *index = &workspace->tile_index;
+	if(!index->dirty && index->cells != NULL) {
+		return 0;
+	}
+	tile_index_free(index);
+
+	uint32_t ntiles = 0;
+	struct nedm_tile *it = workspace->focused_tile;
+	do {
+		++ntiles;
+		it = it->next;
+	} while(it != workspace->focused_tile);
+
+	index->xs = malloc(2 * ntiles * sizeof(int));
+	index->ys = malloc(2 * ntiles * sizeof(int));
+	if(index->xs == NULL || index->ys == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate tile index");
+		tile_index_free(index);
+		return -1;
+	}
+	uint32_t i = 0;
+	it = workspace->focused_tile;
+	do {
+		index->xs[i] = it->tile.x;
+		index->xs[i + 1] = it->tile.x + it->tile.width;
+		index->ys[i] = it->tile.y;
+		index->ys[i + 1] = it->tile.y + it->tile.height;
+		i += 2;
+		it = it->next;
+	} while(it != workspace->focused_tile);
+	index->nxs = sort_unique(index->xs, 2 * ntiles);
+	index->nys = sort_unique(index->ys, 2 * ntiles);
+
+	uint32_t ncols = index->nxs - 1, nrows = index->nys - 1;
+	index->cells = calloc((size_t)ncols * nrows + 1, sizeof(struct nedm_tile *));
+	if(index->cells == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate tile index");
+		tile_index_free(index);
+		return -1;
+	}
+	it = workspace->focused_tile;
+	do {
+		uint32_t x0 = lower_bound(index->xs, index->nxs, it->tile.x);
+		uint32_t x1 =
+		    lower_bound(index->xs, index->nxs, it->tile.x + it->tile.width);
+		uint32_t y0 = lower_bound(index->ys, index->nys, it->tile.y);
+		uint32_t y1 =
+		    lower_bound(index->ys, index->nys, it->tile.y + it->tile.height);
+		for(uint32_t row = y0; row < y1; ++row) {
+			for(uint32_t col = x0; col < x1; ++col) {
+				index->cells[row * ncols + col] = it;
+			}
+		}
+		it = it->next;
+	} while(it != workspace->focused_tile);
+	index->dirty = false;
+	return 0;
+}
+
+static struct nedm_tile *
+tile_index_cell(const struct nedm_tile_index *index, int64_t col, int64_t row) {
+	if(col < 0 || row < 0 || col + 1 >= index->nxs || row + 1 >= index->nys) {
+		return NULL;
+	}
+	return index->cells[row * (index->nxs - 1) + col];
+}
+
+/* Returns the tile containing the point (x,y) given in output local
+ * coordinates or NULL if there is none */
+struct nedm_tile *
+workspace_tile_at(struct nedm_workspace *workspace, double x, double y) {
+	if(tile_index_update(workspace) != 0) {
+		return NULL;
+	}
+	struct nedm_tile_index *index = &workspace->tile_index;
+	if(index->nxs < 2 || index->nys < 2 || x < index->xs[0] ||
+	   y < index->ys[0] || x > index->xs[index->nxs - 1] ||
+	   y > index->ys[index->nys - 1]) {
+		return NULL;
+	}
+	/* A point on an edge shared by two tiles belongs to the tile to the right
+	 * (or below). Points on the right and bottom edges of the workspace
+	 * belong to the tiles along them. */
+	int64_t col = (int64_t)lower_bound(index->xs, index->nxs, x);
+	if(col == index->nxs || index->xs[col] > x) {
+		--col;
+	}
+	int64_t row = (int64_t)lower_bound(index->ys, index->nys, y);
+	if(row == index->nys || index->ys[row] > y) {
+		--row;
+	}
+	if(col == index->nxs - 1) {
+		--col;
+	}
+	if(row == index->nys - 1) {
+		--row;
+	}
+	return tile_index_cell(index, col, row);
+}
+
+/* Returns the tile adjacent to the given tile in the given direction, which
+ * contains the center of the shared edge. If the center lies on the boundary
+ * between two tiles, the one to the left (or top) is returned. */
+struct nedm_tile *
+workspace_tile_neighbour(const struct nedm_tile *tile,
+                         enum nedm_tile_direction direction) {
+	if(tile_index_update(tile->workspace) != 0) {
+		return NULL;
+	}
+	const struct nedm_tile_index *index = &tile->workspace->tile_index;
+	int64_t col = -1, row = -1;
+	switch(direction) {
+	case NEDM_TILE_LEFT:
+	case NEDM_TILE_RIGHT:
+		row = cell_upper_closed(index->ys, index->nys,
+		                        tile->tile.y + tile->tile.height / 2);
+		if(direction == NEDM_TILE_LEFT) {
+			col = index_of(index->xs, index->nxs, tile->tile.x);
+			col = col < 0 ? -1 : col - 1;
+		} else {
+			col = index_of(index->xs, index->nxs,
+			               tile->tile.x + tile->tile.width);
+		}
+		break;
+	case NEDM_TILE_TOP:
+	case NEDM_TILE_BOTTOM:
+		col = cell_upper_closed(index->xs, index->nxs,
+		                        tile->tile.x + tile->tile.width / 2);
+		if(direction == NEDM_TILE_TOP) {
+			row = index_of(index->ys, index->nys, tile->tile.y);
+			row = row < 0 ? -1 : row - 1;
+		} else {
+			row = index_of(index->ys, index->nys,
+			               tile->tile.y + tile->tile.height);
+		}
+		break;
+	}
+	struct nedm_tile *neighbour = tile_index_cell(index, col, row);
+	return neighbour == tile ? NULL : neighbour;
+}
+
 int
 full_screen_workspace_tiles(struct nedm_workspace *workspace,
                             uint32_t *tiles_curr_id) {
@@ -48,6 +267,7 @@ full_screen_workspace_tiles(struct nedm_workspace *workspace,
 	workspace_tile_update_view(workspace->focused_tile, NULL);
 	workspace->focused_tile->id = *tiles_curr_id;
 	++(*tiles_curr_id);
+	workspace_tiles_changed(workspace);
 	return 0;
 }
 
@@ -101,6 +321,8 @@ workspace_free_tiles(struct nedm_workspace *workspace) {
 		free(workspace->focused_tile);
 		workspace->focused_tile = next;
 	}
+	tile_index_free(&workspace->tile_index);
+	workspace_tiles_changed(workspace);
 }
 
 void
@@ -119,6 +341,7 @@ workspace_focus(struct nedm_output *outp, int ws) {
 		        ws, outp->server->nws);
 		return;
 	}
+	++outp->server->scene_generation;
 	wlr_scene_node_place_above(
 	    &outp->bg->node, &outp->workspaces[outp->curr_workspace]->scene->node);
 	wlr_scene_node_place_above(&outp->workspaces[ws]->scene->node,
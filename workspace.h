@@ -4,6 +4,7 @@
 #ifndef NEDM_WORKSPACE_H
 #define NEDM_WORKSPACE_H
 
+#include <stdbool.h>
 #include <wlr/util/box.h>
 
 struct nedm_output;
@@ -18,6 +19,23 @@ struct nedm_tile {
 	uint32_t id;
 };
 
+enum nedm_tile_direction {
+	NEDM_TILE_LEFT,
+	NEDM_TILE_RIGHT,
+	NEDM_TILE_TOP,
+	NEDM_TILE_BOTTOM,
+};
+
+/* Spatial index of the tiles of a workspace. The tile boundaries partition the
+ * workspace into a grid of cells, each of which is covered by at most one
+ * tile. The index is rebuilt lazily after the tiles have changed. */
+struct nedm_tile_index {
+	bool dirty;
+	uint32_t nxs, nys;
+	int *xs, *ys;             // Sorted, distinct tile boundaries
+	struct nedm_tile **cells; // (nxs-1)*(nys-1) cells in row major order
+};
+
 struct nedm_workspace {
 	struct nedm_server *server;
 	struct wl_list views;
@@ -26,6 +44,7 @@ struct nedm_workspace {
 	struct wlr_scene_tree *scene;
 
 	struct nedm_tile *focused_tile;
+	struct nedm_tile_index tile_index;
 	uint32_t num;
 };
 
@@ -44,5 +63,12 @@ void
 workspace_focus(struct nedm_output *outp, int ws);
 void
 workspace_tile_update_view(struct nedm_tile *tile, struct nedm_view *view);
+void
+workspace_tiles_changed(struct nedm_workspace *workspace);
+struct nedm_tile *
+workspace_tile_at(struct nedm_workspace *workspace, double x, double y);
+struct nedm_tile *
+workspace_tile_neighbour(const struct nedm_tile *tile,
+                         enum nedm_tile_direction direction);
 
 #endif
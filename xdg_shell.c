@@ -16,6 +16,7 @@
 
 #include "output.h"
 #include "server.h"
+#include "transaction.h"
 #include "view.h"
 #include "workspace.h"
 #include "xdg_shell.h"
@@ -106,13 +107,18 @@ close(struct nedm_view *view) {
 	}
 }
 
-static void
+static uint32_t
 maximize(struct nedm_view *view, int width, int height) {
 	struct nedm_xdg_shell_view *xdg_shell_view = xdg_shell_view_from_view(view);
-	wlr_xdg_toplevel_set_size(xdg_shell_view->toplevel, width, height);
+	struct wlr_xdg_toplevel *toplevel = xdg_shell_view->toplevel;
+	bool resize =
+	    toplevel->current.width != width || toplevel->current.height != height;
+	wlr_xdg_toplevel_set_size(toplevel, width, height);
 	enum wlr_edges edges =
 	    WLR_EDGE_LEFT | WLR_EDGE_RIGHT | WLR_EDGE_TOP | WLR_EDGE_BOTTOM;
-	wlr_xdg_toplevel_set_tiled(xdg_shell_view->toplevel, edges);
+	uint32_t serial = wlr_xdg_toplevel_set_tiled(toplevel, edges);
+	/* Only wait for the client if its size changes */
+	return resize ? serial : 0;
 }
 
 static void
@@ -228,9 +234,21 @@ handle_xdg_shell_toplevel_commit(struct wl_listener *listener,
 			    decoration->wlr_decoration,
 			    WLR_XDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE);
 		}
-		wlr_xdg_surface_schedule_configure(xdg_surface);
+		/* The view is mapped to the focused tile of the current workspace
+		 * (see handle_xdg_shell_surface_map). Sending its size right away
+		 * allows the client to draw its first buffer with the final size. */
+		struct nedm_output *output = view->server->curr_output;
+		if(output != NULL) {
+			struct nedm_tile *tile =
+			    output->workspaces[output->curr_workspace]->focused_tile;
+			maximize(view, tile->tile.width, tile->tile.height);
+		} else {
+			wlr_xdg_surface_schedule_configure(xdg_surface);
+		}
 		wlr_xdg_toplevel_set_wm_capabilities(
 		    xdg_shell_view->toplevel, XDG_TOPLEVEL_WM_CAPABILITIES_FULLSCREEN);
+	} else {
+		transaction_view_ack(view, xdg_surface->current.configure_serial);
 	}
 }
 
@@ -283,6 +301,7 @@ handle_xdg_shell_popup_destroy(struct wl_listener *listener,
 	wl_list_remove(&popup->commit.link);
 	wl_list_remove(&popup->reposition.link);
 	wlr_scene_node_destroy(&popup->scene_tree->node);
+	++popup->view->server->scene_generation;
 	free(popup);
 }
 
@@ -290,6 +309,7 @@ static void
 handle_xdg_shell_popup_commit(struct wl_listener *listener,
                               __attribute__((unused)) void *data) {
 	struct nedm_xdg_shell_popup *popup = wl_container_of(listener, popup, commit);
+	++popup->view->server->scene_generation;
 	if(popup->wlr_popup->base->initial_commit) {
 		popup_unconstrain(popup);
 	}
@@ -16,6 +16,7 @@
 
 #include "output.h"
 #include "server.h"
+#include "transaction.h"
 #include "view.h"
 #include "workspace.h"
 #include "xwayland.h"
@@ -82,7 +83,7 @@ close(struct nedm_view *view) {
 	wlr_xwayland_surface_close(xwayland_view->xwayland_surface);
 }
 
-static void
+static uint32_t
 maximize(struct nedm_view *view, int width, int height) {
 	struct nedm_xwayland_view *xwayland_view = xwayland_view_from_view(view);
 	xcb_size_hints_t *hints = xwayland_view->xwayland_surface->size_hints;
@@ -104,6 +105,19 @@ maximize(struct nedm_view *view, int width, int height) {
 	    height);
 	wlr_xwayland_surface_set_maximized(xwayland_view->xwayland_surface, true,
 	                                   true);
+	/* The client only commits if its size changes, a new position is
+	 * applied with the rest of the transaction */
+	struct wlr_surface *surface = xwayland_view->xwayland_surface->surface;
+	if(surface == NULL ||
+	   (surface->current.width == width && surface->current.height == height)) {
+		return 0;
+	}
+	if(++xwayland_view->configure_serial == 0) {
+		++xwayland_view->configure_serial;
+	}
+	xwayland_view->configure_width = width;
+	xwayland_view->configure_height = height;
+	return xwayland_view->configure_serial;
 }
 
 static void
@@ -123,6 +137,19 @@ handle_xwayland_surface_request_fullscreen(struct wl_listener *listener,
 	                                    xwayland_surface->fullscreen);
 }
 
+static void
+handle_xwayland_surface_commit(struct wl_listener *listener,
+                               __attribute__((unused)) void *data) {
+	struct nedm_xwayland_view *xwayland_view =
+	    wl_container_of(listener, xwayland_view, commit);
+	struct wlr_surface *surface = xwayland_view->xwayland_surface->surface;
+	if(surface->current.width == xwayland_view->configure_width &&
+	   surface->current.height == xwayland_view->configure_height) {
+		transaction_view_ack(&xwayland_view->view,
+		                     xwayland_view->configure_serial);
+	}
+}
+
 static void
 handle_xwayland_surface_unmap(struct wl_listener *listener,
                               __attribute__((unused)) void *_data) {
@@ -189,6 +216,8 @@ handle_xwayland_surface_associate(struct wl_listener *listener,
 	xwayland_view->unmap.notify = handle_xwayland_surface_unmap;
 	wl_signal_add(&xsurface->surface->events.map, &xwayland_view->map);
 	xwayland_view->map.notify = handle_xwayland_surface_map;
+	wl_signal_add(&xsurface->surface->events.commit, &xwayland_view->commit);
+	xwayland_view->commit.notify = handle_xwayland_surface_commit;
 }
 
 static void
@@ -198,6 +227,7 @@ handle_xwayland_surface_dissociate(struct wl_listener *listener,
 	    wl_container_of(listener, xwayland_view, dissociate);
 	wl_list_remove(&xwayland_view->map.link);
 	wl_list_remove(&xwayland_view->unmap.link);
+	wl_list_remove(&xwayland_view->commit.link);
 }
 
 void
@@ -11,6 +11,12 @@ struct nedm_xwayland_view {
 	struct wlr_xwayland_surface *xwayland_surface;
 	struct wlr_scene_tree *scene_tree;
 
+	/* X11 has no configure serials. A configure counts as acked once the
+	 * surface commits with the size it was configured to. */
+	uint32_t configure_serial;
+	int configure_width, configure_height;
+
+	struct wl_listener commit;
 	struct wl_listener destroy;
 	struct wl_listener unmap;
 	struct wl_listener map;